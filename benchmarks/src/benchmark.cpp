@@ -0,0 +1,176 @@
+// --------------------------------------------------------------------
+// This file is part of libDistMesh.
+//
+// libDistMesh is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// libDistMesh is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libDistMesh. If not, see <http://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2015 Patrik Gebhardt
+// Contact: patrik.gebhardt@rub.de
+// --------------------------------------------------------------------
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <numeric>
+#include <cstdlib>
+#include <cmath>
+#include <distmesh/distmesh.h>
+#include "helper.h"
+
+#ifndef GIT_VERSION
+#define GIT_VERSION "unknown"
+#endif
+
+// wall times of all repetitions of a single benchmark
+struct Result {
+    std::string name;
+    unsigned size;
+    std::vector<double> times;
+};
+
+// run benchmark after an untimed warm up, the setup is called before each
+// repetition and is not included in the measured time
+template <
+    class setup_t,
+    class benchmark_t
+>
+Result measure(std::string const& name, unsigned const size, unsigned const repetitions,
+    setup_t setup, benchmark_t benchmark) {
+    Result result{ name, size, std::vector<double>() };
+
+    setup();
+    benchmark();
+    for (unsigned repetition = 0; repetition < repetitions; ++repetition) {
+        setup();
+
+        distmesh::helper::HighPrecisionTime time;
+        benchmark();
+        result.times.push_back(time.elapsed());
+    }
+
+    std::cerr << name << " (" << size << " points): " <<
+        *std::min_element(result.times.begin(), result.times.end()) * 1e3 << " ms" << std::endl;
+
+    return result;
+}
+
+// write results as json document including the minimum, median and mean time
+void report(std::vector<Result> const& results, unsigned const repetitions) {
+    std::cout << std::setprecision(9) << "{" << std::endl;
+    std::cout << "  \"version\": \"" << GIT_VERSION << "\"," << std::endl;
+    std::cout << "  \"repetitions\": " << repetitions << "," << std::endl;
+    std::cout << "  \"benchmarks\": [" << std::endl;
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto times = results[i].times;
+        std::sort(times.begin(), times.end());
+        double const median = times.size() % 2 == 1 ? times[times.size() / 2] :
+            0.5 * (times[times.size() / 2 - 1] + times[times.size() / 2]);
+        double const mean = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+
+        std::cout << "    { \"name\": \"" << results[i].name << "\", \"size\": " << results[i].size <<
+            ", \"min\": " << times.front() << ", \"median\": " << median << ", \"mean\": " << mean <<
+            ", \"max\": " << times.back() << " }" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+
+    std::cout << "  ]" << std::endl << "}" << std::endl;
+}
+
+// usage: benchmark [maxSize] [repetitions], results are written to stdout
+int main(int argc, char* argv[]) {
+    unsigned const maxSize = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    unsigned const repetitions = argc > 2 ? std::max(std::strtoul(argv[2], nullptr, 10), 1ul) : 5;
+
+    // corner points of polygon of the polygon example
+    Eigen::ArrayXXd polygon(10, 2);
+    polygon << -0.4, -0.5, 0.4, -0.2, 0.4, -0.7,
+        1.5, -0.4, 0.9, 0.1, 1.6, 0.8, 0.5, 0.5,
+        0.2, 1.0, 0.1, 0.4, -0.7, 0.7;
+
+    std::vector<std::pair<std::string, distmesh::Functional>> const distanceFunctions = {
+        { "distanceFunction::rectangular", distmesh::distanceFunction::rectangular(
+            distmesh::utils::boundingBox(2)) },
+        { "distanceFunction::elliptical", distmesh::distanceFunction::elliptical(
+            (Eigen::ArrayXd(2) << 1.0, 0.5).finished()) },
+        { "distanceFunction::circular", distmesh::distanceFunction::circular(1.0) },
+        { "distanceFunction::polygon", distmesh::distanceFunction::polygon(polygon) }
+    };
+
+    // prevents the compiler from discarding results
+    volatile double sink = 0.0;
+
+    std::vector<Result> results;
+    for (unsigned size = 1000; size <= maxSize; size *= 10) {
+        // same random points in the square [-1.2, 1.2]^2 for every run
+        std::srand(size);
+        Eigen::ArrayXXd const points = 1.2 * Eigen::ArrayXXd::Random(size, 2);
+
+        Eigen::ArrayXXi triangulation;
+        results.push_back(measure("triangulation::delaunay", size, repetitions, []{}, [&]{
+            triangulation = distmesh::triangulation::delaunay(points);
+        }));
+
+        Eigen::ArrayXXi edges;
+        results.push_back(measure("utils::findUniqueEdges", size, repetitions, []{}, [&]{
+            edges = distmesh::utils::findUniqueEdges(triangulation);
+        }));
+
+        Eigen::ArrayXXi edgeIndices;
+        results.push_back(measure("utils::getTriangulationEdgeIndices", size, repetitions, []{}, [&]{
+            edgeIndices = distmesh::utils::getTriangulationEdgeIndices(triangulation, edges);
+        }));
+
+        results.push_back(measure("utils::boundEdges", size, repetitions, []{}, [&]{
+            sink = sink + distmesh::utils::boundEdges(triangulation, edges, edgeIndices).size();
+        }));
+
+        Eigen::ArrayXXd edgeVectors(edges.rows(), 2), edgeMidpoints(edges.rows(), 2);
+        Eigen::ArrayXd edgeLengths(edges.rows());
+        results.push_back(measure("utils::edgeGeometry", size, repetitions, []{}, [&]{
+            distmesh::utils::edgeGeometry<double>(points, edges, edgeVectors, edgeLengths,
+                edgeMidpoints);
+        }));
+
+        results.push_back(measure("quality::radiusRatio", size, repetitions, []{}, [&]{
+            sink = sink + distmesh::quality::radiusRatio(points, triangulation).sum();
+        }));
+
+        // choose point distance to get about size points within the unit circle,
+        // for the hexagonal initial distribution
+        double const initialPointDistance = std::sqrt(2.0 * M_PI / (std::sqrt(3.0) * size));
+        results.push_back(measure("utils::createInitialPoints", size, repetitions, []{}, [&]{
+            sink = sink + distmesh::utils::createInitialPoints(
+                distmesh::distanceFunction::circular(1.0), initialPointDistance, 1.0,
+                distmesh::utils::boundingBox(2), Eigen::ArrayXXd()).rows();
+        }));
+
+        Eigen::ArrayXXd projectedPoints;
+        results.push_back(measure("utils::projectPointsToBoundary", size, repetitions,
+            [&]{ projectedPoints = points; }, [&]{
+            distmesh::utils::projectPointsToBoundary<double>(distmesh::distanceFunction::circular(1.0),
+                initialPointDistance, projectedPoints);
+        }));
+
+        for (auto const& distanceFunction : distanceFunctions) {
+            results.push_back(measure(distanceFunction.first, size, repetitions, []{}, [&]{
+                sink = sink + distanceFunction.second(points).sum();
+            }));
+        }
+    }
+
+    report(results, repetitions);
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+// --------------------------------------------------------------------
+// This file is part of libDistMesh.
+//
+// libDistMesh is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// libDistMesh is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libDistMesh. If not, see <http://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2015 Patrik Gebhardt
+// Contact: patrik.gebhardt@rub.de
+// --------------------------------------------------------------------
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <distmesh/distmesh.h>
+#include "helper.h"
+
+#ifndef GIT_VERSION
+#define GIT_VERSION "unknown"
+#endif
+
+// geometry of one of the bundled examples
+struct Example {
+    std::string name;
+    distmesh::Functional distanceFunction;
+    double initialPointDistance;
+    distmesh::Functional elementSizeFunction;
+    Eigen::ArrayXXd boundingBox;
+    Eigen::ArrayXXd fixedPoints;
+};
+
+// configuration of the solver for the force equilibrium
+struct Configuration {
+    std::string name;
+    distmesh::Solver solver;
+    bool adaptiveTimeStep;
+};
+
+// compares the number of iterations until convergence of all solvers on the
+// geometries of the bundled examples, the initial point distance of the
+// examples is divided by the given refinement
+// usage: solvers [refinement], results are written to stdout
+int main(int argc, char* argv[]) {
+    double const refinement = argc > 1 ? std::max(std::atof(argv[1]), 1.0) : 1.0;
+
+    // corner points of polygon of the polygon example
+    Eigen::ArrayXXd polygon(10, 2);
+    polygon << -0.4, -0.5, 0.4, -0.2, 0.4, -0.7,
+        1.5, -0.4, 0.9, 0.1, 1.6, 0.8, 0.5, 0.5,
+        0.2, 1.0, 0.1, 0.4, -0.7, 0.7;
+
+    // edge size function of the square example
+    Eigen::ArrayXXd poly(2, 2);
+    poly << 0.3, 0.7, 0.7, 0.5;
+    auto sizeFunction =
+        (0.01 + 0.3 * distmesh::distanceFunction::circular(0.0).abs())
+        .min(0.025 + 0.3 * distmesh::distanceFunction::polygon(poly).abs())
+        .min(0.15);
+
+    std::vector<Example> const examples = {
+        { "ellipse", distmesh::distanceFunction::elliptical((Eigen::ArrayXd(2) << 2.0, 1.0).finished()),
+            0.2, 1.0, (Eigen::ArrayXXd(2, 2) << -2.0, -1.0, 2.0, 1.0).finished(), Eigen::ArrayXXd() },
+        { "polygon", distmesh::distanceFunction::polygon(polygon), 0.1, 1.0,
+            distmesh::utils::boundingBox(2), polygon },
+        { "rectangle_with_circular_hole", distmesh::distanceFunction::rectangle(
+            distmesh::utils::boundingBox(2)).max(-distmesh::distanceFunction::circular(0.5)),
+            0.05, 0.05 + 0.3 * distmesh::distanceFunction::circular(0.5),
+            distmesh::utils::boundingBox(2), Eigen::ArrayXXd() },
+        { "square", distmesh::distanceFunction::rectangle(
+            (Eigen::ArrayXXd(2, 2) << 0.0, 0.0, 1.0, 1.0).finished()), 0.01, sizeFunction,
+            (Eigen::ArrayXXd(2, 2) << 0.0, 0.0, 1.0, 1.0).finished(), Eigen::ArrayXXd() },
+        { "unit_circle", distmesh::distanceFunction::circular(1.0), 0.2, 1.0,
+            distmesh::utils::boundingBox(2), Eigen::ArrayXXd() }
+    };
+
+    std::vector<Configuration> const configurations = {
+        { "euler", distmesh::Solver::Euler, false },
+        { "euler_adaptive", distmesh::Solver::Euler, true },
+        { "nesterov", distmesh::Solver::Nesterov, false },
+        { "nesterov_adaptive", distmesh::Solver::Nesterov, true }
+    };
+
+    // write results as json document
+    std::cout << std::setprecision(9) << "{" << std::endl;
+    std::cout << "  \"version\": \"" << GIT_VERSION << "\"," << std::endl;
+    std::cout << "  \"refinement\": " << refinement << "," << std::endl;
+    std::cout << "  \"runs\": [" << std::endl;
+
+    for (size_t i = 0; i < examples.size(); ++i)
+    for (size_t j = 0; j < configurations.size(); ++j) {
+        auto const& example = examples[i];
+        auto const& configuration = configurations[j];
+
+        // fixed seed for the same initial points of every run
+        distmesh::Options options;
+        options.solver = configuration.solver;
+        options.adaptiveTimeStep = configuration.adaptiveTimeStep;
+        options.seed = 1;
+
+        distmesh::Statistics statistics;
+        Eigen::ArrayXXd points;
+        Eigen::ArrayXXi elements;
+        std::tie(points, elements) = distmesh::distmesh(example.distanceFunction,
+            example.initialPointDistance / refinement, example.elementSizeFunction,
+            example.boundingBox, example.fixedPoints, options, &statistics);
+
+        // radius ratio of the final mesh to compare the solvers by their result
+        Eigen::ArrayXd const quality = distmesh::quality::radiusRatio(points, elements);
+
+        std::cerr << example.name << " (" << configuration.name << "): " <<
+            statistics.steps << " steps, quality " << quality.minCoeff() << " min, " <<
+            quality.mean() << " mean" << std::endl;
+
+        std::cout << "    { \"example\": \"" << example.name << "\", \"solver\": \"" <<
+            configuration.name << "\", \"points\": " << points.rows() << ", \"steps\": " <<
+            statistics.steps << ", \"retriangulations\": " << statistics.retriangulations <<
+            ", \"restarts\": " << statistics.restarts << ", \"minQuality\": " << quality.minCoeff() <<
+            ", \"meanQuality\": " << quality.mean() << ", \"time\": " << statistics.totalTime <<
+            " }" << (i + 1 < examples.size() || j + 1 < configurations.size() ? "," : "") <<
+            std::endl;
+    }
+
+    std::cout << "  ]" << std::endl << "}" << std::endl;
+
+    return 0;
+}
@@ -23,6 +23,17 @@
 
 #include <fstream>
 #include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 namespace distmesh {
 namespace helper {
@@ -40,6 +51,336 @@ namespace helper {
         file.close();
     }
 
+    namespace binary {
+        // all sections of the binary mesh format start at multiples of the alignment
+        static uint64_t const alignment = 64;
+        static char const magic[8] = { 'D', 'I', 'S', 'T', 'M', 'E', 'S', 'H' };
+        static uint32_t const version = 2;
+
+        // written in native byte order, files of the other byte order read it
+        // with reversed bytes and are rejected, since arrays are mapped in place
+        static uint32_t const byteOrder = 0x01020304;
+
+        enum DataType : uint32_t {
+            Float64 = 1, Int32 = 2
+        };
+
+        // the points, elements, edges and boundary sections follow the header,
+        // each storing an array in column major order, like Eigen does
+        enum Section {
+            Points = 0, Elements, Edges, Boundary, SectionCount
+        };
+
+        struct Header {
+            char magic[8];
+            uint32_t version;
+            uint32_t byteOrder;
+            uint32_t dimension;
+            uint32_t scalarType;
+            uint32_t indexType;
+            uint32_t reserved;
+            uint64_t rows[SectionCount];
+            uint64_t cols[SectionCount];
+            uint64_t offsets[SectionCount];
+        };
+
+        inline uint64_t align(uint64_t const offset) {
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+
+        // pad file with zeros up to the offset and write array column by column
+        template <typename type>
+        void write(std::ofstream& file, uint64_t const offset,
+            Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const array) {
+            static char const padding[alignment] = {};
+            file.write(padding, offset - static_cast<uint64_t>(file.tellp()));
+
+            for (int col = 0; col < array.cols(); ++col) {
+                file.write(reinterpret_cast<char const*>(array.col(col).data()),
+                    array.rows() * sizeof(type));
+            }
+        }
+    }
+
+    // save mesh to compact binary file, which can be mapped into memory by MappedMesh,
+    // edges and boundary are optional
+    inline void savebin(std::string const& filename,
+        Eigen::Ref<Eigen::ArrayXXd const> const points,
+        Eigen::Ref<Eigen::ArrayXXi const> const elements,
+        Eigen::Ref<Eigen::ArrayXXi const> const edges=Eigen::ArrayXXi(),
+        Eigen::Ref<Eigen::ArrayXXi const> const boundary=Eigen::ArrayXXi()) {
+        binary::Header header = {};
+        std::memcpy(header.magic, binary::magic, sizeof(header.magic));
+        header.version = binary::version;
+        header.byteOrder = binary::byteOrder;
+        header.dimension = points.cols();
+        header.scalarType = binary::Float64;
+        header.indexType = binary::Int32;
+
+        // place sections one after another
+        Eigen::Index const rows[] = { points.rows(), elements.rows(), edges.rows(), boundary.rows() };
+        Eigen::Index const cols[] = { points.cols(), elements.cols(), edges.cols(), boundary.cols() };
+        uint64_t offset = binary::align(sizeof(header));
+        for (int section = 0; section < binary::SectionCount; ++section) {
+            header.rows[section] = rows[section];
+            header.cols[section] = cols[section];
+            header.offsets[section] = offset;
+            offset = binary::align(offset + rows[section] * cols[section] *
+                (section == binary::Points ? sizeof(double) : sizeof(int)));
+        }
+
+        std::ofstream file(filename, std::ios::binary);
+        file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        binary::write<double>(file, header.offsets[binary::Points], points);
+        binary::write<int>(file, header.offsets[binary::Elements], elements);
+        binary::write<int>(file, header.offsets[binary::Edges], edges);
+        binary::write<int>(file, header.offsets[binary::Boundary], boundary);
+
+        file.close();
+    }
+
+    // read only view of a mesh saved by savebin, the file is mapped into
+    // memory and all arrays are accessed in place without parsing
+    class MappedMesh {
+    private:
+        void* data;
+        size_t size;
+        binary::Header const* header;
+
+        template <typename type>
+        Eigen::Map<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> section(
+            binary::Section const section) const {
+            return Eigen::Map<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const>(
+                reinterpret_cast<type const*>(static_cast<char const*>(this->data) +
+                    this->header->offsets[section]),
+                this->header->rows[section], this->header->cols[section]);
+        }
+
+        // check header and extent of all sections
+        bool valid() const {
+            if ((this->size < sizeof(binary::Header)) ||
+                (std::memcmp(this->header->magic, binary::magic, sizeof(binary::magic)) != 0) ||
+                (this->header->version != binary::version) ||
+                (this->header->byteOrder != binary::byteOrder) ||
+                (this->header->scalarType != binary::Float64) ||
+                (this->header->indexType != binary::Int32)) {
+                return false;
+            }
+
+            // compare the number of elements with the elements available behind
+            // the offset by divisions, since the size of a corrupted section
+            // might overflow
+            uint64_t const maxIndex = std::numeric_limits<Eigen::Index>::max();
+            for (int section = 0; section < binary::SectionCount; ++section) {
+                uint64_t const rows = this->header->rows[section];
+                uint64_t const cols = this->header->cols[section];
+                uint64_t const offset = this->header->offsets[section];
+                if ((offset % binary::alignment != 0) || (offset > this->size) ||
+                    (rows > maxIndex) || (cols > maxIndex)) {
+                    return false;
+                }
+
+                uint64_t const available = (this->size - offset) /
+                    (section == binary::Points ? sizeof(double) : sizeof(int));
+                if ((cols != 0) && (rows > available / cols)) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+    public:
+        explicit MappedMesh(std::string const& filename)
+            : data(MAP_FAILED), size(0), header(nullptr) {
+            int const file = open(filename.c_str(), O_RDONLY);
+            if (file < 0) {
+                throw std::runtime_error("cannot open mesh file: " + filename);
+            }
+
+            struct stat status;
+            if (fstat(file, &status) == 0) {
+                this->size = status.st_size;
+                this->data = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, file, 0);
+            }
+            close(file);
+
+            if (this->data == MAP_FAILED) {
+                throw std::runtime_error("cannot map mesh file: " + filename);
+            }
+            this->header = static_cast<binary::Header const*>(this->data);
+            if (!this->valid()) {
+                munmap(this->data, this->size);
+                throw std::runtime_error("invalid mesh file: " + filename);
+            }
+        }
+
+        ~MappedMesh() {
+            munmap(this->data, this->size);
+        }
+
+        // the mapping cannot be shared
+        MappedMesh(MappedMesh const&) = delete;
+        MappedMesh& operator=(MappedMesh const&) = delete;
+
+        unsigned dimension() const {
+            return this->header->dimension;
+        }
+
+        Eigen::Map<Eigen::ArrayXXd const> points() const {
+            return this->section<double>(binary::Points);
+        }
+
+        Eigen::Map<Eigen::ArrayXXi const> elements() const {
+            return this->section<int>(binary::Elements);
+        }
+
+        Eigen::Map<Eigen::ArrayXXi const> edges() const {
+            return this->section<int>(binary::Edges);
+        }
+
+        Eigen::Map<Eigen::ArrayXXi const> boundary() const {
+            return this->section<int>(binary::Boundary);
+        }
+    };
+
+    namespace binary {
+        // number of rows converted at once by the streaming exporters
+        static Eigen::Index const chunkSize = 4096;
+
+        // stream array given row wise by the value of each row and column,
+        // converting chunks of rows to the target type at once
+        template <typename target, typename value_t>
+        void writeRows(std::ofstream& file, Eigen::Index const rows, Eigen::Index const cols,
+            value_t value) {
+            std::vector<target> buffer(std::min(rows, chunkSize) * cols);
+            for (Eigen::Index start = 0; start < rows; start += chunkSize) {
+                Eigen::Index const count = std::min(chunkSize, rows - start);
+                for (Eigen::Index row = 0; row < count; ++row)
+                for (Eigen::Index col = 0; col < cols; ++col) {
+                    buffer[row * cols + col] = static_cast<target>(value(start + row, col));
+                }
+
+                file.write(reinterpret_cast<char const*>(buffer.data()),
+                    count * cols * sizeof(target));
+            }
+        }
+
+        // points are always exported with three coordinates
+        inline double coordinate(Eigen::Ref<Eigen::ArrayXXd const> const& points,
+            Eigen::Index const row, Eigen::Index const col) {
+            return col < points.cols() ? points(row, col) : 0.0;
+        }
+    }
+
+    // save mesh as binary VTK unstructured grid (.vtu) with appended raw data,
+    // elements can be lines, triangles or tetrahedra
+    inline void savevtu(std::string const& filename,
+        Eigen::Ref<Eigen::ArrayXXd const> const points,
+        Eigen::Ref<Eigen::ArrayXXi const> const elements) {
+        uint16_t const endianness = 1;
+        uint8_t const cellType = elements.cols() == 2 ? 3 : (elements.cols() == 3 ? 5 : 10);
+
+        // sizes of the appended arrays, each preceded by its size in bytes
+        uint64_t const sizes[] = {
+            static_cast<uint64_t>(points.rows() * 3 * sizeof(double)),
+            static_cast<uint64_t>(elements.size() * sizeof(int32_t)),
+            static_cast<uint64_t>(elements.rows() * sizeof(int32_t)),
+            static_cast<uint64_t>(elements.rows() * sizeof(uint8_t)) };
+        uint64_t offsets[4] = { 0 };
+        for (int array = 1; array < 4; ++array) {
+            offsets[array] = offsets[array - 1] + sizeof(uint64_t) + sizes[array - 1];
+        }
+
+        std::ofstream file(filename, std::ios::binary);
+        file << "<?xml version=\"1.0\"?>\n" <<
+            "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"" <<
+            (*reinterpret_cast<uint8_t const*>(&endianness) == 1 ? "LittleEndian" : "BigEndian") <<
+            "\" header_type=\"UInt64\">\n" <<
+            "  <UnstructuredGrid>\n" <<
+            "    <Piece NumberOfPoints=\"" << points.rows() << "\" NumberOfCells=\"" <<
+            elements.rows() << "\">\n" <<
+            "      <Points>\n" <<
+            "        <DataArray type=\"Float64\" NumberOfComponents=\"3\" format=\"appended\" offset=\"" <<
+            offsets[0] << "\"/>\n" <<
+            "      </Points>\n" <<
+            "      <Cells>\n" <<
+            "        <DataArray type=\"Int32\" Name=\"connectivity\" format=\"appended\" offset=\"" <<
+            offsets[1] << "\"/>\n" <<
+            "        <DataArray type=\"Int32\" Name=\"offsets\" format=\"appended\" offset=\"" <<
+            offsets[2] << "\"/>\n" <<
+            "        <DataArray type=\"UInt8\" Name=\"types\" format=\"appended\" offset=\"" <<
+            offsets[3] << "\"/>\n" <<
+            "      </Cells>\n" <<
+            "    </Piece>\n" <<
+            "  </UnstructuredGrid>\n" <<
+            "  <AppendedData encoding=\"raw\">\n" <<
+            "   _";
+
+        file.write(reinterpret_cast<char const*>(&sizes[0]), sizeof(uint64_t));
+        binary::writeRows<double>(file, points.rows(), 3, [&](Eigen::Index const row,
+            Eigen::Index const col) { return binary::coordinate(points, row, col); });
+
+        file.write(reinterpret_cast<char const*>(&sizes[1]), sizeof(uint64_t));
+        binary::writeRows<int32_t>(file, elements.rows(), elements.cols(), [&](
+            Eigen::Index const row, Eigen::Index const col) { return elements(row, col); });
+
+        file.write(reinterpret_cast<char const*>(&sizes[2]), sizeof(uint64_t));
+        binary::writeRows<int32_t>(file, elements.rows(), 1, [&](Eigen::Index const row,
+            Eigen::Index) { return (row + 1) * elements.cols(); });
+
+        file.write(reinterpret_cast<char const*>(&sizes[3]), sizeof(uint64_t));
+        binary::writeRows<uint8_t>(file, elements.rows(), 1, [&](Eigen::Index,
+            Eigen::Index) { return cellType; });
+
+        file << "\n  </AppendedData>\n</VTKFile>\n";
+        file.close();
+    }
+
+    // save mesh as binary Gmsh file (.msh version 4.1) with all nodes and
+    // elements in a single entity, elements can be lines, triangles or tetrahedra
+    inline void savemsh(std::string const& filename,
+        Eigen::Ref<Eigen::ArrayXXd const> const points,
+        Eigen::Ref<Eigen::ArrayXXi const> const elements) {
+        int32_t const one = 1;
+        int32_t const dimension = elements.cols() - 1;
+        int32_t const elementType = elements.cols() == 2 ? 1 : (elements.cols() == 3 ? 2 : 4);
+
+        std::ofstream file(filename, std::ios::binary);
+        file << "$MeshFormat\n4.1 1 " << sizeof(uint64_t) << "\n";
+        file.write(reinterpret_cast<char const*>(&one), sizeof(one));
+        file << "\n$EndMeshFormat\n";
+
+        // nodes are numbered starting with one
+        uint64_t const nodes[] = { 1, static_cast<uint64_t>(points.rows()), 1,
+            static_cast<uint64_t>(points.rows()) };
+        int32_t const nodeEntity[] = { dimension, 1, 0 };
+        file << "$Nodes\n";
+        file.write(reinterpret_cast<char const*>(nodes), sizeof(nodes));
+        file.write(reinterpret_cast<char const*>(nodeEntity), sizeof(nodeEntity));
+        file.write(reinterpret_cast<char const*>(&nodes[1]), sizeof(uint64_t));
+        binary::writeRows<uint64_t>(file, points.rows(), 1, [](Eigen::Index const row,
+            Eigen::Index) { return row + 1; });
+        binary::writeRows<double>(file, points.rows(), 3, [&](Eigen::Index const row,
+            Eigen::Index const col) { return binary::coordinate(points, row, col); });
+        file << "\n$EndNodes\n";
+
+        // each element is given by its tag followed by its node tags
+        uint64_t const elementBlocks[] = { 1, static_cast<uint64_t>(elements.rows()), 1,
+            static_cast<uint64_t>(elements.rows()) };
+        int32_t const elementEntity[] = { dimension, 1, elementType };
+        file << "$Elements\n";
+        file.write(reinterpret_cast<char const*>(elementBlocks), sizeof(elementBlocks));
+        file.write(reinterpret_cast<char const*>(elementEntity), sizeof(elementEntity));
+        file.write(reinterpret_cast<char const*>(&elementBlocks[1]), sizeof(uint64_t));
+        binary::writeRows<uint64_t>(file, elements.rows(), elements.cols() + 1, [&](
+            Eigen::Index const row, Eigen::Index const col) {
+            return col == 0 ? row + 1 : elements(row, col - 1) + 1; });
+        file << "\n$EndElements\n";
+
+        file.close();
+    }
+
     class HighPrecisionTime {
     private:
         std::chrono::high_resolution_clock::time_point time;
@@ -0,0 +1,69 @@
+// --------------------------------------------------------------------
+// This file is part of libDistMesh.
+//
+// libDistMesh is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// libDistMesh is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libDistMesh. If not, see <http://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2015 Patrik Gebhardt
+// Contact: patrik.gebhardt@rub.de
+// --------------------------------------------------------------------
+
+#ifndef _4a2e7eae_92ab_4e80_b153_a26a50be011e
+#define _4a2e7eae_92ab_4e80_b153_a26a50be011e
+
+#include <vector>
+
+namespace distmesh {
+namespace batch {
+    // parameter of a single mesh generation
+    struct Job {
+        Job(Functional const& distanceFunction, double const initialPointDistance,
+            Functional const& elementSizeFunction=1.0,
+            Eigen::Ref<Eigen::ArrayXXd const> const boundingBox=utils::boundingBox(2),
+            Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints=Eigen::ArrayXXd(),
+            Options const& options=Options())
+            : distanceFunction(distanceFunction), initialPointDistance(initialPointDistance),
+            elementSizeFunction(elementSizeFunction), boundingBox(boundingBox),
+            fixedPoints(fixedPoints), options(options) {}
+
+        Functional distanceFunction;
+        double initialPointDistance;
+        Functional elementSizeFunction;
+        Eigen::ArrayXXd boundingBox;
+        Eigen::ArrayXXd fixedPoints;
+
+        // options of the job, which is always run by a single thread, jobs
+        // without a seed are seeded by their index plus one, so the initial
+        // points do not depend on the scheduling of the jobs
+        Options options;
+    };
+
+    // generated mesh of a single job
+    struct Result {
+        Result() : time(0.0) {}
+
+        Eigen::ArrayXXd points;
+        Eigen::ArrayXXi triangulation;
+        Statistics statistics;
+
+        // wall time spent for mesh generation in seconds
+        double time;
+    };
+
+    // generate meshes for all jobs on a work stealing pool of threads,
+    // using all hardware threads for zero, results are in order of the jobs
+    std::vector<Result> distmesh(std::vector<Job> const& jobs, unsigned const threads=0);
+}
+}
+
+#endif
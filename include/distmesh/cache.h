@@ -0,0 +1,140 @@
+// --------------------------------------------------------------------
+// This file is part of libDistMesh.
+//
+// libDistMesh is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// libDistMesh is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libDistMesh. If not, see <http://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2015 Patrik Gebhardt
+// Contact: patrik.gebhardt@rub.de
+// --------------------------------------------------------------------
+
+#ifndef _a099ab46_e4b9_4c7e_aef9_1534ccf1b0b6
+#define _a099ab46_e4b9_4c7e_aef9_1534ccf1b0b6
+
+namespace distmesh {
+namespace cache {
+    // adaptive tree (quadtree in 2d, octree in 3d) storing samples of a Functional
+    // at the corners of its cells, which are refined near the zero level set,
+    // until the multilinear interpolation reproduces the Functional within the
+    // given tolerance
+    class Tree {
+    public:
+        // sample functional within bounding box
+        Tree(Functional const& functional, Eigen::Ref<Eigen::ArrayXXd const> const boundingBox,
+            double const tolerance, unsigned const maxDepth=12, unsigned const minDepth=3);
+
+        // interpolate functional for all points, points outside of the
+        // bounding box are evaluated by the functional itself
+        Eigen::ArrayXd operator() (Eigen::Ref<Eigen::ArrayXXd const> const points) const;
+
+        // interpolate functional for single precision points, the interpolation
+        // weights are calculated in double precision per point
+        Eigen::ArrayXf operator() (Eigen::Ref<Eigen::ArrayXXf const> const points) const;
+
+        // interpolate functional alongside its gradient
+        std::tuple<Eigen::ArrayXd, Eigen::ArrayXXd> gradient(
+            Eigen::Ref<Eigen::ArrayXXd const> const points) const;
+
+        // accessors
+        Eigen::ArrayXXd const& boundingBox() const { return this->boundingBox_; }
+        unsigned cellCount() const { return this->children_.size(); }
+        double tolerance() const { return this->tolerance_; }
+
+    private:
+        // interpolate functional for points of the given scalar type
+        template <
+            class type
+        >
+        Eigen::Array<type, Eigen::Dynamic, 1> evaluate(
+            Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points) const;
+
+        // find leaf containing point, returns cell index, its depth and the local
+        // coordinates of the point, which extrapolate the nearest leaf for
+        // points outside of the bounding box
+        int findCell(double const* const point, double* const coordinates,
+            unsigned& depth) const;
+
+        Functional functional_;
+        Eigen::ArrayXXd boundingBox_;
+        double tolerance_;
+
+        // size of the cells of each depth
+        Eigen::ArrayXXd cellSizes_;
+
+        // first child of each cell or -1 for leafs, and samples at the corners
+        // of each cell, with the bits of the corner index marking the upper
+        // side of each dimension
+        std::vector<int> children_;
+        std::vector<double> values_;
+    };
+
+    // regular background grid storing samples of a Functional at its nodes,
+    // e.g. an element size function, which is evaluated by multilinear
+    // interpolation, points outside of the bounding box use the nearest
+    // point on it
+    class Grid {
+    public:
+        // sample functional within bounding box with given spacing, optionally
+        // the increase of the values between neighbouring nodes is limited by
+        // the gradation times their distance, an upper bound below the lower
+        // bound of the bounding box is clamped to the lower bound
+        Grid(Functional const& functional, Eigen::Ref<Eigen::ArrayXXd const> const boundingBox,
+            double const spacing, double const gradation=0.0);
+
+        // interpolate functional for all points
+        Eigen::ArrayXd operator() (Eigen::Ref<Eigen::ArrayXXd const> const points) const;
+
+        // interpolate functional for single precision points, the interpolation
+        // weights are calculated in double precision per point
+        Eigen::ArrayXf operator() (Eigen::Ref<Eigen::ArrayXXf const> const points) const;
+
+        // accessors
+        Eigen::ArrayXXd const& boundingBox() const { return this->boundingBox_; }
+        Eigen::ArrayXi const& shape() const { return this->shape_; }
+        Eigen::ArrayXd const& spacing() const { return this->spacing_; }
+        Eigen::ArrayXd const& values() const { return this->values_; }
+
+    private:
+        // interpolate functional for points of the given scalar type
+        template <
+            class type
+        >
+        Eigen::Array<type, Eigen::Dynamic, 1> evaluate(
+            Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points) const;
+
+        // limit gradation of values by propagating them from the smallest
+        // to the largest value along the edges of the grid
+        void limitGradation(double const gradation);
+
+        Eigen::ArrayXXd boundingBox_;
+        Eigen::ArrayXi shape_;
+        Eigen::ArrayXi strides_;
+        Eigen::ArrayXd spacing_;
+        Eigen::ArrayXd values_;
+    };
+
+    // sample functional once on a regular background grid and wrap it into
+    // a Functional, which answers evaluations by interpolation
+    Functional backgroundGrid(Functional const& functional,
+        Eigen::Ref<Eigen::ArrayXXd const> const boundingBox, double const spacing,
+        double const gradation=0.0);
+
+    // sample functional once into an adaptive tree and wrap it into a Functional,
+    // which answers evaluations by interpolation
+    Functional adaptive(Functional const& functional,
+        Eigen::Ref<Eigen::ArrayXXd const> const boundingBox, double const tolerance,
+        unsigned const maxDepth=12, unsigned const minDepth=3);
+}
+}
+
+#endif
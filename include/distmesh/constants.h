@@ -29,12 +29,31 @@ namespace constants {
     // triangulation is updated, when maximum relative points movement is above threshold
     static double const retriangulationThreshold = 1e-1;
 
+    // triangulation is updated locally by edge flips instead of being recreated
+    // from scratch, when possible (2d only)
+    static bool const incrementalRetriangulation = true;
+
     // relative threshold in the geometry evaluations
     static double const geometryEvaluationThreshold = 1e-3;
 
     // time step for updating points positions with Euler's method
     static double const deltaT = 1e-1;
 
+    // bounds and factors of the adaptive time step, which grows while the
+    // force residual decreases and is reduced on oscillation
+    static double const maxDeltaT = 4e-1;
+    static double const minDeltaT = 1e-2;
+    static double const deltaTGrowth = 1.1;
+    static double const deltaTReduction = 0.5;
+
+    // momentum of the accelerated solver
+    static double const momentum = 0.85;
+
+    // percentile of the element quality used for quality based stopping, the
+    // worst element by default, since already the initial mesh satisfies
+    // most targets except for few degenerated elements at the boundary
+    static double const qualityPercentile = 0.0;
+
     // step size for numerical differentiation
     static double const deltaX = std::sqrt(std::numeric_limits<double>::epsilon());
 
@@ -23,23 +23,266 @@
 
 // standard c++ lib
 #include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 #include <tuple>
+#include <cstdint>
 
 // Eigen lib for array handling
 #include <Eigen/Core>
 
 // libdistmesh includes
 #include "functional.h"
+#include "expression.h"
+#include "tape.h"
+#include "cache.h"
 #include "distance_function.h"
 #include "utils.h"
+#include "quality.h"
+#include "triangulation.h"
+#include "parallel.h"
 
 namespace distmesh {
-    // apply the distmesh algorithm
+    // state of a single iteration of the distmesh algorithm including the
+    // wall time in seconds spent in each of its phases
+    struct Iteration {
+        Iteration() : step(0), retriangulated(false), restarted(false), maxMovement(0.0),
+            edgeCount(0), deltaT(0.0), residual(0.0), quality(0.0), delaunayTime(0.0),
+            edgeTime(0.0), forceTime(0.0), projectionTime(0.0) {}
+
+        unsigned step;
+        bool retriangulated;
+
+        // momentum of the accelerated solver was reset
+        bool restarted;
+
+        double maxMovement;
+        unsigned edgeCount;
+
+        // time step used and root mean square of the nodal forces
+        double deltaT;
+        double residual;
+
+        // percentile of the radius ratio of all elements, only evaluated
+        // for quality based stopping
+        double quality;
+
+        double delaunayTime;
+        double edgeTime;
+        double forceTime;
+        double projectionTime;
+    };
+
+    // observer called after each iteration of the distmesh algorithm
+    typedef std::function<void(Iteration const&)> observer_t;
+
+    // statistics collected during a single run of the distmesh algorithm
+    struct Statistics {
+        Statistics() : steps(0), retriangulations(0), restarts(0), maxMovement(0.0),
+            edgeCount(0), quality(0.0), initializationTime(0.0), delaunayTime(0.0), edgeTime(0.0),
+            forceTime(0.0), projectionTime(0.0), totalTime(0.0) {}
+
+        // number of iterations until convergence
+        unsigned steps;
+
+        // number of triangulation updates
+        unsigned retriangulations;
+
+        // number of momentum resets of the accelerated solver
+        unsigned restarts;
+
+        // points movement, number of edges and quality of the last iteration
+        double maxMovement;
+        unsigned edgeCount;
+        double quality;
+
+        // wall time in seconds spent in each phase summed over all iterations
+        double initializationTime;
+        double delaunayTime;
+        double edgeTime;
+        double forceTime;
+        double projectionTime;
+        double totalTime;
+    };
+
+    // solver for the force equilibrium, either explicit Euler's method or
+    // Nesterov's accelerated method, which extrapolates the points by their
+    // previous movement before evaluating the forces
+    enum class Solver {
+        Euler, Nesterov
+    };
+
+    // runtime parameters of the distmesh algorithm, defaults are given
+    // by the values of constants.h
+    struct Options {
+        Options();
+
+        // solver and momentum of the accelerated solver
+        Solver solver;
+        double momentum;
+
+        // time step for updating points positions
+        double deltaT;
+
+        // relative points movement thresholds for updating the triangulation
+        // and for stopping the algorithm
+        double retriangulationThreshold;
+        double pointsMovementThreshold;
+
+        // maximum number of iterations
+        unsigned maxSteps;
+
+        // stop, when the given percentile of the radius ratio of all elements
+        // reaches the target quality, disabled for zero target quality, only
+        // supported in two and three dimensions
+        double targetQuality;
+        double qualityPercentile;
+
+        // adapt time step between its bounds, it grows by the growth factor
+        // while the force residual decreases and is reduced by the reduction
+        // factor, when the residual increases due to oscillation
+        bool adaptiveTimeStep;
+        double minDeltaT;
+        double maxDeltaT;
+        double deltaTGrowth;
+        double deltaTReduction;
+
+        // update triangulation by edge flips instead of retriangulation
+        bool incrementalRetriangulation;
+
+        // number of threads for accumulating the forces, all hardware threads for zero
+        unsigned threads;
+
+        // seed of the random engine for the initial points distribution,
+        // std::rand is used for zero
+        unsigned seed;
+
+        // called after each iteration
+        observer_t observer;
+    };
+
+    // reusable mesh generator, which keeps its triangulator and the workspaces
+    // of the distmesh algorithm, including the triangulation and its edges,
+    // across all iterations and successive runs, the workspaces only grow,
+    // when a larger mesh is generated, only the evaluation of the functionals
+    // and the triangulator still allocate memory
+    template <
+        class type
+    >
+    class BasicMesher {
+    public:
+        typedef Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> array_t;
+
+        explicit BasicMesher(Options const& options=Options());
+
+        // the mesher cannot be copied, since it owns a triangulator
+        BasicMesher(BasicMesher const&) = delete;
+        BasicMesher& operator=(BasicMesher const&) = delete;
+
+        // apply the distmesh algorithm, optionally the statistics of the run are stored
+        std::tuple<array_t, Eigen::ArrayXXi> operator()(
+            Functional const& distanceFunction, double const initialPointDistance,
+            Functional const& elementSizeFunction=1.0,
+            Eigen::Ref<Eigen::ArrayXXd const> const boundingBox=utils::boundingBox(2),
+            Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints=Eigen::ArrayXXd(),
+            Statistics* const statistics=nullptr);
+
+        // apply the distmesh algorithm using the given triangulator
+        std::tuple<array_t, Eigen::ArrayXXi> operator()(
+            triangulation::Triangulator& triangulator,
+            Functional const& distanceFunction, double const initialPointDistance,
+            Functional const& elementSizeFunction=1.0,
+            Eigen::Ref<Eigen::ArrayXXd const> const boundingBox=utils::boundingBox(2),
+            Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints=Eigen::ArrayXXd(),
+            Statistics* const statistics=nullptr);
+
+        // accessors
+        Options& options() { return this->options_; }
+        Options const& options() const { return this->options_; }
+
+    private:
+        typedef Eigen::Map<array_t> workspace_t;
+
+        // view of the workspace with the given size
+        template <
+            class scalar
+        >
+        static Eigen::Map<Eigen::Array<scalar, Eigen::Dynamic, Eigen::Dynamic>> workspace(
+            std::vector<scalar>& buffer, Eigen::Index const rows, Eigen::Index const cols);
+
+        Options options_;
+        triangulation::Triangulator triangulator_;
+
+        // workspaces for points and per edge values
+        std::vector<type> points_;
+        std::vector<type> retriangulationCriterionBuffer_;
+        std::vector<type> stopCriterionBuffer_;
+        std::vector<type> movement_[2];
+        std::vector<type> edgeVector_;
+        std::vector<type> edgeMidpoint_;
+        std::vector<type> edgeLength_;
+        std::vector<type> edgeForce_;
+
+        // workspaces for triangulation and edges of the mesh
+        std::vector<int> delaunayTriangulation_;
+        std::vector<int> triangulation_;
+        std::vector<type> centroids_;
+        std::vector<int> edgeIndices_;
+        std::vector<uint64_t> edgeKeys_;
+        std::vector<int> nodeEdgeOffsets_;
+        std::vector<int> nodeEdges_;
+    };
+
+    // reusable mesh generator in double precision
+    typedef BasicMesher<double> Mesher;
+
+    // apply the distmesh algorithm, the forces are accumulated by the given
+    // number of threads, using all hardware threads for zero
     std::tuple<Eigen::ArrayXXd, Eigen::ArrayXXi> distmesh(
         Functional const& distanceFunction, double const initialPointDistance,
         Functional const& elementSizeFunction=1.0,
         Eigen::Ref<Eigen::ArrayXXd const> const boundingBox=utils::boundingBox(2),
-        Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints=Eigen::ArrayXXd());
+        Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints=Eigen::ArrayXXd(),
+        unsigned const threads=1);
+
+    // apply the distmesh algorithm with the given options
+    std::tuple<Eigen::ArrayXXd, Eigen::ArrayXXi> distmesh(
+        Functional const& distanceFunction, double const initialPointDistance,
+        Functional const& elementSizeFunction,
+        Eigen::Ref<Eigen::ArrayXXd const> const boundingBox,
+        Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints,
+        Options const& options, Statistics* const statistics=nullptr);
+
+    // apply the distmesh algorithm using the given triangulator, meshes can be
+    // generated concurrently, when each thread uses its own triangulator,
+    // optionally the statistics of the run are stored
+    std::tuple<Eigen::ArrayXXd, Eigen::ArrayXXi> distmesh(
+        triangulation::Triangulator& triangulator,
+        Functional const& distanceFunction, double const initialPointDistance,
+        Functional const& elementSizeFunction=1.0,
+        Eigen::Ref<Eigen::ArrayXXd const> const boundingBox=utils::boundingBox(2),
+        Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints=Eigen::ArrayXXd(),
+        Options const& options=Options(), Statistics* const statistics=nullptr);
+
+    // apply the distmesh algorithm storing points and forces in the given scalar
+    // type, instantiated for single and double precision, distance and element
+    // size functions are evaluated in the same precision, if they support it
+    // (see Functional::single()), all convergence criteria, the gradient of the
+    // distance function and the triangulation are evaluated in double precision
+    template <
+        class type
+    >
+    std::tuple<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic>, Eigen::ArrayXXi> distmesh(
+        triangulation::Triangulator& triangulator,
+        Functional const& distanceFunction, double const initialPointDistance,
+        Functional const& elementSizeFunction=1.0,
+        Eigen::Ref<Eigen::ArrayXXd const> const boundingBox=utils::boundingBox(2),
+        Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints=Eigen::ArrayXXd(),
+        Options const& options=Options(), Statistics* const statistics=nullptr);
 }
 
+// libdistmesh includes depending on the options of the distmesh algorithm
+#include "batch.h"
+
 #endif
@@ -0,0 +1,436 @@
+// --------------------------------------------------------------------
+// This file is part of libDistMesh.
+//
+// libDistMesh is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// libDistMesh is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libDistMesh. If not, see <http://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2015 Patrik Gebhardt
+// Contact: patrik.gebhardt@rub.de
+// --------------------------------------------------------------------
+
+#ifndef _7b414919_7b7d_4ccd_acff_2b7815d47124
+#define _7b414919_7b7d_4ccd_acff_2b7815d47124
+
+#include <cmath>
+#include <algorithm>
+
+namespace distmesh {
+namespace expression {
+    // number of points evaluated at once, all expressions operate on fixed size
+    // blocks of values, which allows vectorization of the fused loop
+    static int const blockSize = 16;
+    typedef Eigen::Array<double, blockSize, 1> Block;
+    typedef Eigen::Array<bool, blockSize, 1> Mask;
+
+    // binary operations
+    struct Add { static Block apply(Block const& a, Block const& b) { return a + b; } };
+    struct Subtract { static Block apply(Block const& a, Block const& b) { return a - b; } };
+    struct Multiply { static Block apply(Block const& a, Block const& b) { return a * b; } };
+    struct Divide { static Block apply(Block const& a, Block const& b) { return a / b; } };
+    struct Minimum { static Block apply(Block const& a, Block const& b) { return a.min(b); } };
+    struct Maximum { static Block apply(Block const& a, Block const& b) { return a.max(b); } };
+
+    template <class Lhs, class Rhs, class Operation> class Binary;
+    template <class Operand> class Negate;
+    template <class Operand> class Abs;
+    template <class Operand> class Shift;
+    template <class Operand> class Rotate2D;
+
+    // read access to a coordinate of a block of consecutive points of a points
+    // array, which is a contiguous segment of a column of the column major array,
+    // incomplete blocks at the end of the array are padded by their last point
+    class PointBlock {
+    public:
+        PointBlock(Eigen::Ref<Eigen::ArrayXXd const> const& points, int const row,
+            int const count) : points_(points), row_(row), count_(count) {}
+
+        Block operator()(int const dim) const {
+            if (this->count_ == blockSize) {
+                return this->points_.col(dim).template segment<blockSize>(this->row_);
+            }
+
+            Block block = Block::Constant(this->points_(this->row_ + this->count_ - 1, dim));
+            block.head(this->count_) = this->points_.col(dim).segment(this->row_, this->count_);
+            return block;
+        }
+        int size() const { return this->points_.cols(); }
+
+    private:
+        Eigen::Ref<Eigen::ArrayXXd const> const& points_;
+        int const row_;
+        int const count_;
+    };
+
+    // base class of all compile time function expressions, the complete
+    // expression is evaluated block by block in a single loop without
+    // temporary arrays or indirect function calls, expressions provide no
+    // analytic gradient, so projectPointsToBoundary falls back to finite
+    // differences for them
+    template <
+        class Derived
+    >
+    class Expression {
+    public:
+        Derived const& derived() const { return static_cast<Derived const&>(*this); }
+
+        // evaluate expression for all points
+        Eigen::ArrayXd operator() (Eigen::Ref<Eigen::ArrayXXd const> const points) const {
+            Eigen::ArrayXd result(points.rows());
+            for (int row = 0; row < points.rows(); row += blockSize) {
+                int const count = std::min<int>(blockSize, points.rows() - row);
+                Block const block = this->derived().evaluate(PointBlock(points, row, count));
+                result.segment(row, count) = block.head(count);
+            }
+            return result;
+        }
+
+        // basic arithmetic operations
+        Expression const& operator+() const { return *this; }
+        Negate<Derived> operator-() const { return Negate<Derived>(this->derived()); }
+
+        // mathematical methods
+        template <class Rhs>
+        Binary<Derived, Rhs, Minimum> min(Expression<Rhs> const& rhs) const {
+            return Binary<Derived, Rhs, Minimum>(this->derived(), rhs.derived());
+        }
+        template <class Rhs>
+        Binary<Derived, Rhs, Maximum> max(Expression<Rhs> const& rhs) const {
+            return Binary<Derived, Rhs, Maximum>(this->derived(), rhs.derived());
+        }
+        Abs<Derived> abs() const { return Abs<Derived>(this->derived()); }
+
+        // geometric transform
+        Shift<Derived> shift(Eigen::Ref<Eigen::ArrayXd const> const offset) const {
+            return Shift<Derived>(this->derived(), offset);
+        }
+        Rotate2D<Derived> rotate2D(double const angle) const {
+            return Rotate2D<Derived>(this->derived(), angle);
+        }
+    };
+
+    // constant value
+    class Constant : public Expression<Constant> {
+    public:
+        Constant(double const value) : value_(value) {}
+
+        template <class Point>
+        Block evaluate(Point const&) const { return Block::Constant(this->value_); }
+
+    private:
+        double value_;
+    };
+
+    // combination of two expressions
+    template <
+        class Lhs,
+        class Rhs,
+        class Operation
+    >
+    class Binary : public Expression<Binary<Lhs, Rhs, Operation>> {
+    public:
+        Binary(Lhs const& lhs, Rhs const& rhs) : lhs_(lhs), rhs_(rhs) {}
+
+        template <class Point>
+        Block evaluate(Point const& point) const {
+            return Operation::apply(this->lhs_.evaluate(point), this->rhs_.evaluate(point));
+        }
+
+    private:
+        Lhs lhs_;
+        Rhs rhs_;
+    };
+
+    template <
+        class Operand
+    >
+    class Negate : public Expression<Negate<Operand>> {
+    public:
+        Negate(Operand const& operand) : operand_(operand) {}
+
+        template <class Point>
+        Block evaluate(Point const& point) const { return -this->operand_.evaluate(point); }
+
+    private:
+        Operand operand_;
+    };
+
+    template <
+        class Operand
+    >
+    class Abs : public Expression<Abs<Operand>> {
+    public:
+        Abs(Operand const& operand) : operand_(operand) {}
+
+        template <class Point>
+        Block evaluate(Point const& point) const { return this->operand_.evaluate(point).abs(); }
+
+    private:
+        Operand operand_;
+    };
+
+    // evaluates operand at points shifted by offset
+    template <
+        class Operand
+    >
+    class Shift : public Expression<Shift<Operand>> {
+    public:
+        Shift(Operand const& operand, Eigen::Ref<Eigen::ArrayXd const> const offset)
+            : operand_(operand), offset_(offset) {}
+
+        template <class Point>
+        class ShiftedPoint {
+        public:
+            ShiftedPoint(Point const& point, Eigen::ArrayXd const& offset)
+                : point_(point), offset_(offset) {}
+
+            Block operator()(int const dim) const { return this->point_(dim) - this->offset_(dim); }
+            int size() const { return this->point_.size(); }
+
+        private:
+            Point const& point_;
+            Eigen::ArrayXd const& offset_;
+        };
+
+        template <class Point>
+        Block evaluate(Point const& point) const {
+            return this->operand_.evaluate(ShiftedPoint<Point>(point, this->offset_));
+        }
+
+    private:
+        Operand operand_;
+        Eigen::ArrayXd offset_;
+    };
+
+    // evaluates operand at points rotated by angle in the first two dimensions
+    template <
+        class Operand
+    >
+    class Rotate2D : public Expression<Rotate2D<Operand>> {
+    public:
+        Rotate2D(Operand const& operand, double const angle)
+            : operand_(operand), cos_(std::cos(angle)), sin_(std::sin(angle)) {}
+
+        template <class Point>
+        class RotatedPoint {
+        public:
+            RotatedPoint(Point const& point, double const cos, double const sin)
+                : point_(point), cos_(cos), sin_(sin) {}
+
+            Block operator()(int const dim) const {
+                return dim == 0 ? this->point_(0) * this->cos_ + this->point_(1) * this->sin_ :
+                    (dim == 1 ? -this->point_(0) * this->sin_ + this->point_(1) * this->cos_ :
+                    this->point_(dim));
+            }
+            int size() const { return this->point_.size(); }
+
+        private:
+            Point const& point_;
+            double const cos_;
+            double const sin_;
+        };
+
+        template <class Point>
+        Block evaluate(Point const& point) const {
+            return this->operand_.evaluate(RotatedPoint<Point>(point, this->cos_, this->sin_));
+        }
+
+    private:
+        Operand operand_;
+        double cos_;
+        double sin_;
+    };
+
+    // arithmetic operations between expressions and with constants
+#define DISTMESH_EXPRESSION_OPERATOR(op, operation) \
+    template <class Lhs, class Rhs> \
+    Binary<Lhs, Rhs, operation> operator op(Expression<Lhs> const& lhs, Expression<Rhs> const& rhs) { \
+        return Binary<Lhs, Rhs, operation>(lhs.derived(), rhs.derived()); \
+    } \
+    template <class Lhs> \
+    Binary<Lhs, Constant, operation> operator op(Expression<Lhs> const& lhs, double const rhs) { \
+        return Binary<Lhs, Constant, operation>(lhs.derived(), Constant(rhs)); \
+    } \
+    template <class Rhs> \
+    Binary<Constant, Rhs, operation> operator op(double const lhs, Expression<Rhs> const& rhs) { \
+        return Binary<Constant, Rhs, operation>(Constant(lhs), rhs.derived()); \
+    }
+
+    DISTMESH_EXPRESSION_OPERATOR(+, Add)
+    DISTMESH_EXPRESSION_OPERATOR(-, Subtract)
+    DISTMESH_EXPRESSION_OPERATOR(*, Multiply)
+    DISTMESH_EXPRESSION_OPERATOR(/, Divide)
+#undef DISTMESH_EXPRESSION_OPERATOR
+
+    // distance function for a nd rectangular domain
+    // Attention: Not a real distance function at the corners of domain
+    class Rectangular : public Expression<Rectangular> {
+    public:
+        Rectangular(Eigen::Ref<Eigen::ArrayXXd const> const rectangle) : rectangle_(rectangle) {}
+
+        template <class Point>
+        Block evaluate(Point const& point) const {
+            Block result = (point(0) - this->rectangle_(0, 0)).min(this->rectangle_(1, 0) - point(0));
+            for (int dim = 1; dim < point.size(); ++dim) {
+                result = result.min((point(dim) - this->rectangle_(0, dim))
+                    .min(this->rectangle_(1, dim) - point(dim)));
+            }
+            return -result;
+        }
+
+    private:
+        Eigen::ArrayXXd rectangle_;
+    };
+
+    // true distance function for a 2d rectangular domain
+    class Rectangle : public Expression<Rectangle> {
+    public:
+        Rectangle(Eigen::Ref<Eigen::ArrayXXd const> const rectangle) : rectangle_(rectangle) {}
+
+        template <class Point>
+        Block evaluate(Point const& point) const {
+            // distances to all 4 sides of rectangle
+            Block const d1 = this->rectangle_(0, 1) - point(1);
+            Block const d2 = -this->rectangle_(1, 1) + point(1);
+            Block const d3 = this->rectangle_(0, 0) - point(0);
+            Block const d4 = -this->rectangle_(1, 0) + point(0);
+
+            // distance to nearest side or corner of rectangle, outside of the
+            // rectangle only the positive distances contribute to the corner distance
+            Block const dx = d3.max(d4), dy = d1.max(d2);
+            return (dx.max(0.0).square() + dy.max(0.0).square()).sqrt() + dx.max(dy).min(0.0);
+        }
+
+    private:
+        Eigen::ArrayXXd rectangle_;
+    };
+
+    // level function for elliptical domains
+    class Elliptical : public Expression<Elliptical> {
+    public:
+        Elliptical(Eigen::Ref<Eigen::ArrayXd const> const radii=Eigen::ArrayXd(),
+            Eigen::Ref<Eigen::ArrayXd const> const midpoint=Eigen::ArrayXd())
+            : radii_(radii), midpoint_(midpoint) {}
+
+        template <class Point>
+        Block evaluate(Point const& point) const {
+            Block result = Block::Zero();
+            for (int dim = 0; dim < point.size(); ++dim) {
+                Block const x = (point(dim) - (this->midpoint_.rows() == point.size() ? this->midpoint_(dim) : 0.0)) /
+                    (this->radii_.rows() == point.size() ? this->radii_(dim) : 1.0);
+                result += x * x;
+            }
+            return result.sqrt() - 1.0;
+        }
+
+    private:
+        Eigen::ArrayXd radii_;
+        Eigen::ArrayXd midpoint_;
+    };
+
+    // true distance function for circular domains
+    class Circular : public Expression<Circular> {
+    public:
+        Circular(double const radius=1.0, Eigen::Ref<Eigen::ArrayXd const> const midpoint=Eigen::ArrayXd())
+            : radius_(radius), midpoint_(midpoint) {}
+
+        template <class Point>
+        Block evaluate(Point const& point) const {
+            Block result = Block::Zero();
+            for (int dim = 0; dim < point.size(); ++dim) {
+                Block const x = point(dim) - (this->midpoint_.rows() == point.size() ? this->midpoint_(dim) : 0.0);
+                result += x * x;
+            }
+            return result.sqrt() - this->radius_;
+        }
+
+    private:
+        double radius_;
+        Eigen::ArrayXd midpoint_;
+    };
+
+    // distance function for a 2d domain described by polygon
+    // Attention: Not a real distance function at the corners of domain
+    class Polygon : public Expression<Polygon> {
+    public:
+        Polygon(Eigen::Ref<Eigen::ArrayXXd const> const polygon) : polygon_(polygon) {}
+
+        template <class Point>
+        Block evaluate(Point const& point) const {
+            Block const x = point(0), y = point(1);
+            Block distance = Block::Constant(INFINITY);
+            Mask inside = Mask::Constant(false);
+
+            for (int i = 0, j = this->polygon_.rows() - 1; i < this->polygon_.rows(); j = i++) {
+                double const xi = this->polygon_(i, 0), yi = this->polygon_(i, 1);
+                double const xj = this->polygon_(j, 0), yj = this->polygon_(j, 1);
+
+                // squared distance to edge from node j to node i
+                double const c2 = (xi - xj) * (xi - xj) + (yi - yj) * (yi - yj);
+                Block const t = c2 > 0.0 ? Block(((xi - xj) * (x - xj) + (yi - yj) * (y - yj))
+                    .max(0.0).min(c2) / c2) : Block(Block::Zero());
+                distance = distance.min((x - xj - (xi - xj) * t).square() +
+                    (y - yj - (yi - yj) * t).square());
+
+                // check whether points lie inside of polygon
+                Mask const crossing = ((y < yi) != (y < yj)) &&
+                    (x < (xj - xi) * (y - yi) / (yj - yi) + xi);
+                inside = inside != crossing;
+            }
+
+            distance = distance.sqrt();
+            return inside.select(-distance, distance);
+        }
+
+    private:
+        Eigen::ArrayXXd polygon_;
+    };
+
+    // creation of distance functions with the same interface as distanceFunction
+    inline Rectangular rectangular(Eigen::Ref<Eigen::ArrayXXd const> const rectangle) {
+        return Rectangular(rectangle);
+    }
+    inline Rectangle rectangle(Eigen::Ref<Eigen::ArrayXXd const> const rectangle) {
+        return Rectangle(rectangle);
+    }
+    inline Elliptical elliptical(Eigen::Ref<Eigen::ArrayXd const> const radii=Eigen::ArrayXd(),
+        Eigen::Ref<Eigen::ArrayXd const> const midpoint=Eigen::ArrayXd()) {
+        return Elliptical(radii, midpoint);
+    }
+    inline Circular circular(double const radius=1.0,
+        Eigen::Ref<Eigen::ArrayXd const> const midpoint=Eigen::ArrayXd()) {
+        return Circular(radius, midpoint);
+    }
+    inline Polygon polygon(Eigen::Ref<Eigen::ArrayXXd const> const polygon) {
+        return Polygon(polygon);
+    }
+
+    // wrap copy of expression into std function
+    template <
+        class Derived
+    >
+    Functional::function_t function(Derived const& derived) {
+        return [=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> Eigen::ArrayXd {
+            return derived(points);
+        };
+    }
+}
+
+// create type erased Functional from compile time expression
+template <
+    class Derived
+>
+Functional::Functional(expression::Expression<Derived> const& expression)
+    : Functional(expression::function(expression.derived())) {}
+}
+
+#endif
@@ -27,22 +27,54 @@
         function_body))
 
 namespace distmesh {
-    // base class of all function expression for allowing easy function arithmetic
+    namespace expression {
+        template <class Derived> class Expression;
+    }
+    namespace tape {
+        struct Node;
+    }
+
+    // base class of all function expression for allowing easy function arithmetic,
+    // alongside the std function a symbolic description is recorded, which allows
+    // compilation into a tape (see tape.h)
     class Functional {
     public:
         // function type of Functional callable
         typedef std::function<Eigen::ArrayXd(Eigen::Ref<Eigen::ArrayXXd const> const)> function_t;
 
-        // create class from function type
-        Functional(function_t const& func) : function_(func) {}
-        Functional(double const constant) :
-            Functional(DISTMESH_FUNCTIONAL({
-                return Eigen::ArrayXd::Constant(points.rows(),constant);
-            })) {}
+        // function type evaluating function values alongside their gradient
+        typedef std::function<std::tuple<Eigen::ArrayXd, Eigen::ArrayXXd>(
+            Eigen::Ref<Eigen::ArrayXXd const> const)> gradient_t;
+
+        // function type evaluating function values in single precision
+        typedef std::function<Eigen::ArrayXf(Eigen::Ref<Eigen::ArrayXXf const> const)> single_t;
+
+        // create class from function type, optionally with its analytic gradient
+        Functional(function_t const& func, gradient_t const& gradient=nullptr);
+        Functional(double const constant);
+
+        // create class from function type with its symbolic description
+        Functional(function_t const& func, gradient_t const& gradient,
+            std::shared_ptr<tape::Node const> const& node)
+            : function_(func), gradient_(gradient), single_(nullptr), node_(node) {}
+
+        // create class from function type, which is identified by its name and
+        // parameters, e.g. built-in distance functions
+        Functional(function_t const& func, gradient_t const& gradient,
+            std::string const& name, std::vector<double> const& parameters);
+
+        // create class from compile time expression, defined in expression.h,
+        // expressions provide no analytic gradient, so points are projected to
+        // the boundary using finite differences
+        template <class Derived>
+        Functional(expression::Expression<Derived> const& expression);
 
         // copy constructor
-        Functional(Functional const& rhs) : function_(rhs.function()) {}
-        Functional(Functional&& rhs) : function_(std::move(rhs.function())) {}
+        Functional(Functional const& rhs) : function_(rhs.function()),
+            gradient_(rhs.gradient()), single_(rhs.single()), node_(rhs.node()) {}
+        Functional(Functional&& rhs) : function_(std::move(rhs.function())),
+            gradient_(std::move(rhs.gradient())), single_(std::move(rhs.single())),
+            node_(std::move(rhs.node_)) {}
 
         // assignment operator
         Functional& operator=(Functional const& rhs);
@@ -51,6 +83,10 @@ namespace distmesh {
         // evaluate function by call
         Eigen::ArrayXd operator() (Eigen::Ref<Eigen::ArrayXXd const> const points) const;
 
+        // evaluate function in single precision, points are cast to double,
+        // if no single precision evaluation is available
+        Eigen::ArrayXf operator() (Eigen::Ref<Eigen::ArrayXXf const> const points) const;
+
         // basic arithmetic operations
         Functional operator+() const { return *this; }
         Functional operator-() const;
@@ -87,10 +123,29 @@ namespace distmesh {
         // accessors
         function_t& function() { return this->function_; }
         function_t const& function() const { return this->function_; }
+        gradient_t& gradient() { return this->gradient_; }
+        gradient_t const& gradient() const { return this->gradient_; }
+        bool hasGradient() const { return this->gradient_ != nullptr; }
+        single_t& single() { return this->single_; }
+        single_t const& single() const { return this->single_; }
+        bool hasSingle() const { return this->single_ != nullptr; }
+        std::shared_ptr<tape::Node const> const& node() const { return this->node_; }
 
     private:
         // stores std function
         function_t function_;
+
+        // stores std function evaluating the gradient, if available
+        gradient_t gradient_;
+
+        // stores std function evaluating in single precision, if available,
+        // which is provided by constants, the built-in distance functions, their
+        // arithmetic combinations and geometric transforms, and is kept by
+        // tape::compile and the wrappers of cache.h
+        single_t single_;
+
+        // symbolic description of function
+        std::shared_ptr<tape::Node const> node_;
     };
 }
 
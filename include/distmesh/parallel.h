@@ -0,0 +1,41 @@
+// --------------------------------------------------------------------
+// This file is part of libDistMesh.
+//
+// libDistMesh is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// libDistMesh is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libDistMesh. If not, see <http://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2015 Patrik Gebhardt
+// Contact: patrik.gebhardt@rub.de
+// --------------------------------------------------------------------
+
+#ifndef _e8b6894b_e2dc_4a91_92ea_c47ceb614be0
+#define _e8b6894b_e2dc_4a91_92ea_c47ceb614be0
+
+namespace distmesh {
+namespace parallel {
+    // task executed for a single index by the given worker thread
+    typedef std::function<void(unsigned const index, unsigned const thread)> task_t;
+
+    // number of concurrent threads supported by the hardware
+    unsigned hardwareThreads();
+
+    // execute task for all indices in range [0, count) on a work stealing pool
+    // of the given number of threads, using all hardware threads for zero,
+    // exceptions thrown by any task are rethrown after all threads finished.
+    // The threads are created once and reused by all calls, nested calls and
+    // calls concurrent to another one are executed by the calling thread only
+    void forEach(unsigned const count, unsigned const threads, task_t const& task);
+}
+}
+
+#endif
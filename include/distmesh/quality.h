@@ -0,0 +1,48 @@
+// --------------------------------------------------------------------
+// This file is part of libDistMesh.
+//
+// libDistMesh is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// libDistMesh is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libDistMesh. If not, see <http://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2015 Patrik Gebhardt
+// Contact: patrik.gebhardt@rub.de
+// --------------------------------------------------------------------
+
+#ifndef _3f0c6a2e_9d41_4b7a_a5c8_6e2d17b0f493
+#define _3f0c6a2e_9d41_4b7a_a5c8_6e2d17b0f493
+
+namespace distmesh {
+namespace quality {
+    // radius ratio of all triangles or tetrahedra, i.e. the dimension times the
+    // inradius divided by the circumradius, which is one for regular elements
+    // and zero for degenerated ones, throws std::invalid_argument for any
+    // other element type
+    Eigen::ArrayXd radiusRatio(Eigen::Ref<Eigen::ArrayXXd const> const points,
+        Eigen::Ref<Eigen::ArrayXXi const> const triangulation);
+
+    // interior angles in radians of all triangles, the angle at each node
+    // is stored in the column of the node
+    Eigen::ArrayXXd angles(Eigen::Ref<Eigen::ArrayXXd const> const points,
+        Eigen::Ref<Eigen::ArrayXXi const> const triangulation);
+
+    // dihedral angles in radians of all tetrahedra at their six edges given
+    // in the order of utils::nOverK(4, 2)
+    Eigen::ArrayXXd dihedralAngles(Eigen::Ref<Eigen::ArrayXXd const> const points,
+        Eigen::Ref<Eigen::ArrayXXi const> const triangulation);
+
+    // value below which the given fraction of all values lies
+    double percentile(Eigen::Ref<Eigen::ArrayXd const> const values, double const fraction);
+}
+}
+
+#endif
@@ -0,0 +1,97 @@
+// --------------------------------------------------------------------
+// This file is part of libDistMesh.
+//
+// libDistMesh is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// libDistMesh is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libDistMesh. If not, see <http://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2015 Patrik Gebhardt
+// Contact: patrik.gebhardt@rub.de
+// --------------------------------------------------------------------
+
+#ifndef _120fdea1_6f60_4731_a546_701aa8c6a701
+#define _120fdea1_6f60_4731_a546_701aa8c6a701
+
+namespace distmesh {
+namespace tape {
+    // operations of the symbolic description of a Functional
+    enum class Operation {
+        Function, Constant, Negate, Abs, Add, Subtract, Multiply, Divide,
+        Minimum, Maximum, Shift, Rotate2D
+    };
+
+    // node of the symbolic description of a Functional, which is recorded
+    // alongside the std::function for compilation into a tape
+    struct Node {
+        Node(Operation const operation,
+            std::vector<std::shared_ptr<Node const>> const& operands={},
+            std::vector<double> const& parameters={}, std::string const& name="",
+            Functional::function_t const& function=nullptr)
+            : operation(operation), operands(operands), parameters(parameters),
+            name(name), function(function) {}
+
+        Operation operation;
+        std::vector<std::shared_ptr<Node const>> operands;
+
+        // constant value, offset of shift, angle of rotation or parameters
+        // identifying a built-in distance function
+        std::vector<double> parameters;
+
+        // name of built-in distance functions, functions without name are
+        // only identical to themselves
+        std::string name;
+
+        // function evaluated by Function nodes
+        Functional::function_t function;
+    };
+
+    // flat instruction list of a Functional with common subexpressions
+    // evaluated only once, points are evaluated in blocks of fixed size
+    // using reusable scratch registers
+    class Tape {
+    public:
+        // single instruction writing its result to a value or points register
+        struct Instruction {
+            Operation operation;
+            int result;
+            int lhs;
+            int rhs;
+            Eigen::ArrayXd parameters;
+            Functional::function_t function;
+        };
+
+        // compile functional into tape
+        Tape(Functional const& functional, unsigned const blockSize=256);
+
+        // evaluate tape for all points
+        Eigen::ArrayXd operator() (Eigen::Ref<Eigen::ArrayXXd const> const points) const;
+
+        // accessors
+        std::vector<Instruction> const& instructions() const { return this->instructions_; }
+        unsigned valueRegisters() const { return this->valueRegisters_; }
+        unsigned pointsRegisters() const { return this->pointsRegisters_; }
+        unsigned blockSize() const { return this->blockSize_; }
+
+    private:
+        std::vector<Instruction> instructions_;
+        unsigned valueRegisters_;
+        unsigned pointsRegisters_;
+        unsigned blockSize_;
+        int result_;
+    };
+
+    // compile functional into tape and wrap it into a Functional
+    Functional compile(Functional const& functional, unsigned const blockSize=256);
+}
+}
+
+#endif
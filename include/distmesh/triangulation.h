@@ -21,10 +21,49 @@
 #ifndef _29b995ef_16f0_49e8_a6bf_94f852821a14
 #define _29b995ef_16f0_49e8_a6bf_94f852821a14
 
+// context of the reentrant qhull library
+struct qhT;
+
 namespace distmesh {
 namespace triangulation {
-    // create delaunay triangulation from points array
+    // calculates delaunay triangulations using its own qhull context,
+    // different triangulator objects can be used concurrently in multiple threads
+    class Triangulator {
+    public:
+        Triangulator();
+        ~Triangulator();
+
+        // a qhull context cannot be shared
+        Triangulator(Triangulator const&) = delete;
+        Triangulator& operator=(Triangulator const&) = delete;
+
+        // create delaunay triangulation from points array
+        Eigen::ArrayXXi delaunay(Eigen::Ref<Eigen::ArrayXXd const> const points);
+
+    private:
+        // stores qhull context
+        qhT* context_;
+    };
+
+    // create delaunay triangulation from points array using a temporary triangulator
     Eigen::ArrayXXi delaunay(Eigen::Ref<Eigen::ArrayXXd const> const points);
+
+    // restore delaunay property of an existing 2d triangulation after its points
+    // have been moved by flipping illegal edges. Returns false, if the triangulation
+    // cannot be repaired by edge flips, i.e. an element got inverted or the convex
+    // hull changed, and has to be recreated by delaunay(), instantiated for single
+    // and double precision points, the geometric predicates are always
+    // evaluated in double precision
+    template <
+        class type
+    >
+    bool updateDelaunay(
+        Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points,
+        Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const previousPoints,
+        Eigen::Ref<Eigen::ArrayXXi> triangulation);
+    bool updateDelaunay(Eigen::Ref<Eigen::ArrayXXd const> const points,
+        Eigen::Ref<Eigen::ArrayXXd const> const previousPoints,
+        Eigen::Ref<Eigen::ArrayXXi> triangulation);
 }
 }
 
@@ -72,19 +72,80 @@ namespace utils {
     // easy creation of n-dimensional bounding box
     Eigen::ArrayXXd boundingBox(unsigned const dimensions);
 
-    // create initial points distribution
+    // mark all points lying within the tolerance (maximum norm) to any of the
+    // reference points, using a uniform grid spatial hash of the reference points
+    Eigen::Array<bool, Eigen::Dynamic, 1> findNearbyPoints(
+        Eigen::Ref<Eigen::ArrayXXd const> const points,
+        Eigen::Ref<Eigen::ArrayXXd const> const referencePoints,
+        double const cellSize, double const tolerance, unsigned const threads=1);
+
+    // create initial points distribution, points are rejected randomly by
+    // std::rand, or by a random engine of their own for a non-zero seed
     Eigen::ArrayXXd createInitialPoints(Functional const& distanceFunction,
         double const initialPointDistance, Functional const& elementSizeFunction,
         Eigen::Ref<Eigen::ArrayXXd const> const boundingBox,
-        Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints);
+        Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints, unsigned const threads=1,
+        unsigned const seed=0);
 
     // create array with all unique combinations n over k
     Eigen::ArrayXXi nOverK(unsigned const n, unsigned const k);
 
-    // get a unique list of all edges in given triangulation
-    Eigen::ArrayXXi findUniqueEdges(Eigen::Ref<Eigen::ArrayXXi const> const triangulation);
-
-    // get indices of bars in triangulation
+    // get a unique list of all edges in given triangulation, sorted by their
+    // node indices, large triangulations can be processed by multiple threads
+    Eigen::ArrayXXi findUniqueEdges(Eigen::Ref<Eigen::ArrayXXi const> const triangulation,
+        unsigned const threads=1);
+
+    // get a unique list of all edges stored column major in the given edges, using
+    // keys as scratch space, the capacity of both only grows, returns number of edges
+    int findUniqueEdges(Eigen::Ref<Eigen::ArrayXXi const> const triangulation,
+        std::vector<int>& edges, std::vector<uint64_t>& keys, unsigned const threads=1);
+
+    // create compressed adjacency of nodes to edges, the edges connected to a node
+    // are stored in ascending order in adjacency(offsets(node)) to
+    // adjacency(offsets(node + 1) - 1), edges ending in the node are encoded as -edge - 1
+    std::tuple<Eigen::ArrayXi, Eigen::ArrayXi> nodeEdgeAdjacency(
+        Eigen::Ref<Eigen::ArrayXXi const> const edges, unsigned const nodeCount);
+
+    // create compressed adjacency of nodes to edges in the given storage,
+    // whose capacity only grows
+    void nodeEdgeAdjacency(Eigen::Ref<Eigen::ArrayXXi const> const edges,
+        unsigned const nodeCount, std::vector<int>& offsets, std::vector<int>& adjacency);
+
+    // move all nodes starting with firstNode by the scaled sum of forces of all
+    // edges connected to it, the nodes are processed in parallel by the given number
+    // of threads and the result is independent of the number of threads,
+    // instantiated for single and double precision
+    template <
+        class type
+    >
+    void accumulateForces(
+        Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const forceVector,
+        Eigen::Ref<Eigen::ArrayXi const> const offsets,
+        Eigen::Ref<Eigen::ArrayXi const> const adjacency, double const scale,
+        unsigned const firstNode, Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic>> points,
+        unsigned const threads=1);
+
+    // calculate vectors, lengths and midpoints of all edges in a single pass,
+    // specialized for points of two and three dimensions, all result arrays
+    // have to be allocated with one row per edge
+    template <
+        class type
+    >
+    void edgeGeometry(
+        Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points,
+        Eigen::Ref<Eigen::ArrayXXi const> const edges,
+        Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic>> vectors,
+        Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, 1>> lengths,
+        Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic>> midpoints);
+
+    // create compressed adjacency of edges to elements, the elements containing
+    // an edge are stored in ascending order in adjacency(offsets(edge)) to
+    // adjacency(offsets(edge + 1) - 1)
+    std::tuple<Eigen::ArrayXi, Eigen::ArrayXi> edgeElementAdjacency(
+        Eigen::Ref<Eigen::ArrayXXi const> const edgeIndices, unsigned const edgeCount);
+
+    // get indices of bars in triangulation using the adjacency of nodes to
+    // edges as lookup index, missing edges are marked by -1
     Eigen::ArrayXXi getTriangulationEdgeIndices(Eigen::Ref<Eigen::ArrayXXi const> const triangulation,
         Eigen::Ref<Eigen::ArrayXXi const> const edges);
 
@@ -93,17 +154,36 @@ namespace utils {
         Eigen::Ref<Eigen::ArrayXXi const> const edges=Eigen::ArrayXXi(),
         Eigen::Ref<Eigen::ArrayXXi const> const edgeIndices=Eigen::ArrayXXi());
 
-    // fix orientation of edges located at the boundary
+    // determine boundary faces of given triangulation, i.e. the boundary edges
+    // of triangular meshes and the boundary triangles of tetrahedral meshes
+    Eigen::ArrayXXi boundFaces(Eigen::Ref<Eigen::ArrayXXi const> const triangulation);
+
+    // fix orientation of edges located at the boundary, using the adjacency
+    // of edges to elements to find the element of each boundary edge
     Eigen::ArrayXXi fixBoundaryEdgeOrientation(Eigen::Ref<Eigen::ArrayXXd const> const nodes,
         Eigen::Ref<Eigen::ArrayXXi const> const triangulation,
         Eigen::Ref<Eigen::ArrayXXi const> const edges,
         Eigen::Ref<Eigen::ArrayXXi const> const edgeIndices);
 
-    // project points outside of domain back to boundary
+    // project points outside of domain back to boundary, using the analytic
+    // gradient of the distance function or finite differences, if it has none,
+    // instantiated for single and double precision, the gradient is always
+    // evaluated in double precision
+    template <
+        class type
+    >
     void projectPointsToBoundary(Functional const& distanceFunction,
-        double const initialPointDistance, Eigen::Ref<Eigen::ArrayXXd> points);
+        double const initialPointDistance,
+        Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic>> points);
 
-    // check whether points lies inside or outside of polygon
+    // check whether points lies inside or outside of polygon, instantiated
+    // for single and double precision points
+    template <
+        class type
+    >
+    Eigen::Array<type, Eigen::Dynamic, 1> pointsInsidePoly(
+        Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points,
+        Eigen::Ref<Eigen::ArrayXXd const> const polygon);
     Eigen::ArrayXd pointsInsidePoly(
         Eigen::Ref<Eigen::ArrayXXd const> const points,
         Eigen::Ref<Eigen::ArrayXXd const> const polygon);
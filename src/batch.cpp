@@ -0,0 +1,60 @@
+// --------------------------------------------------------------------
+// This file is part of libDistMesh.
+//
+// libDistMesh is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// libDistMesh is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libDistMesh. If not, see <http://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2015 Patrik Gebhardt
+// Contact: patrik.gebhardt@rub.de
+// --------------------------------------------------------------------
+
+#include <vector>
+#include <chrono>
+
+#include "distmesh/distmesh.h"
+#include "distmesh/parallel.h"
+#include "distmesh/batch.h"
+
+// generate meshes for all jobs on a work stealing pool of threads
+std::vector<distmesh::batch::Result> distmesh::batch::distmesh(
+    std::vector<Job> const& jobs, unsigned const _threads) {
+    unsigned const threads = _threads == 0 ? parallel::hardwareThreads() : _threads;
+
+    // each thread reuses its own mesher with its triangulator and
+    // workspaces for all of its jobs
+    std::vector<Mesher> meshers(threads);
+    std::vector<Result> results(jobs.size());
+
+    parallel::forEach(jobs.size(), threads, [&](unsigned const index, unsigned const thread) {
+        auto const start = std::chrono::steady_clock::now();
+
+        auto const& job = jobs[index];
+        auto& result = results[index];
+        // jobs already run concurrently, so each job uses a single thread
+        // and a random engine of its own
+        Options options = job.options;
+        options.threads = 1;
+        options.seed = options.seed == 0 ? index + 1 : options.seed;
+
+        auto& mesher = meshers[thread];
+        mesher.options() = options;
+        std::tie(result.points, result.triangulation) = mesher(job.distanceFunction,
+            job.initialPointDistance, job.elementSizeFunction, job.boundingBox,
+            job.fixedPoints, &result.statistics);
+
+        result.time = std::chrono::duration_cast<std::chrono::duration<double>>(
+            std::chrono::steady_clock::now() - start).count();
+    });
+
+    return results;
+}
@@ -0,0 +1,443 @@
+// --------------------------------------------------------------------
+// This file is part of libDistMesh.
+//
+// libDistMesh is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// libDistMesh is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libDistMesh. If not, see <http://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2015 Patrik Gebhardt
+// Contact: patrik.gebhardt@rub.de
+// --------------------------------------------------------------------
+
+#include <cmath>
+#include <algorithm>
+#include <queue>
+
+#include "distmesh/distmesh.h"
+
+// multilinear interpolation of the values at the corners of a cell,
+// optionally the gradient with respect to the local coordinates is calculated
+static double interpolate(double const* const values, double const* const coordinates,
+    int const dimension, double* const gradient=nullptr) {
+    double value = 0.0;
+    for (int dim = 0; gradient && (dim < dimension); ++dim) {
+        gradient[dim] = 0.0;
+    }
+
+    for (int corner = 0; corner < (1 << dimension); ++corner) {
+        double weight = 1.0;
+        for (int dim = 0; dim < dimension; ++dim) {
+            weight *= (corner >> dim) & 1 ? coordinates[dim] : 1.0 - coordinates[dim];
+        }
+        value += weight * values[corner];
+
+        for (int dim = 0; gradient && (dim < dimension); ++dim) {
+            double derivative = (corner >> dim) & 1 ? 1.0 : -1.0;
+            for (int other = 0; other < dimension; ++other) {
+                if (other != dim) {
+                    derivative *= (corner >> other) & 1 ? coordinates[other] : 1.0 - coordinates[other];
+                }
+            }
+            gradient[dim] += derivative * values[corner];
+        }
+    }
+
+    return value;
+}
+
+distmesh::cache::Tree::Tree(Functional const& functional,
+    Eigen::Ref<Eigen::ArrayXXd const> const boundingBox, double const tolerance,
+    unsigned const maxDepth, unsigned const minDepth)
+    : functional_(functional), boundingBox_(boundingBox), tolerance_(tolerance),
+    cellSizes_(maxDepth + 1, boundingBox.cols()) {
+    int const dimension = boundingBox.cols();
+    int const corners = 1 << dimension;
+    int const samples = std::pow(3, dimension);
+
+    this->cellSizes_.row(0) = boundingBox.row(1) - boundingBox.row(0);
+    for (unsigned depth = 1; depth <= maxDepth; ++depth) {
+        this->cellSizes_.row(depth) = 0.5 * this->cellSizes_.row(depth - 1);
+    }
+
+    // sample root cell at its corners
+    Eigen::ArrayXXd points(corners, dimension);
+    for (int corner = 0; corner < corners; ++corner)
+    for (int dim = 0; dim < dimension; ++dim) {
+        points(corner, dim) = boundingBox((corner >> dim) & 1, dim);
+    }
+    Eigen::ArrayXd const rootValues = functional(points);
+    this->children_.push_back(-1);
+    this->values_.insert(this->values_.end(), rootValues.data(), rootValues.data() + corners);
+
+    // refine tree level by level, all cells of a level are sampled at once on
+    // a regular grid with 3 points per dimension, which contains the corners
+    // of all potential children
+    std::vector<int> level(1, 0);
+    Eigen::ArrayXXd lower = boundingBox.row(0);
+    for (unsigned depth = 0; (depth < maxDepth) && !level.empty(); ++depth) {
+        Eigen::ArrayXd const size = this->cellSizes_.row(depth).transpose();
+
+        points.resize(level.size() * samples, dimension);
+        for (size_t cell = 0; cell < level.size(); ++cell)
+        for (int sample = 0; sample < samples; ++sample)
+        for (int dim = 0, digit = sample; dim < dimension; ++dim, digit /= 3) {
+            points(cell * samples + sample, dim) = lower(cell, dim) + 0.5 * (digit % 3) * size(dim);
+        }
+        Eigen::ArrayXd const values = functional(points);
+
+        std::vector<int> nextLevel;
+        Eigen::ArrayXXd nextLower(level.size() * corners, dimension);
+        std::vector<double> coordinates(dimension);
+        for (size_t cell = 0; cell < level.size(); ++cell) {
+            double const* const cellValues = &this->values_[level[cell] * corners];
+
+            // maximum error of interpolation at all samples
+            double error = 0.0;
+            for (int sample = 0; sample < samples; ++sample) {
+                for (int dim = 0, digit = sample; dim < dimension; ++dim, digit /= 3) {
+                    coordinates[dim] = 0.5 * (digit % 3);
+                }
+                error = std::max(error, std::abs(values(cell * samples + sample) -
+                    interpolate(cellValues, coordinates.data(), dimension)));
+            }
+
+            // zero level set can only cross the cell, if the distance at its
+            // center is smaller than its diagonal
+            bool const boundary = std::abs(values(cell * samples + (samples - 1) / 2)) <=
+                size.matrix().norm();
+            if ((depth >= minDepth) && (!boundary || (error <= tolerance))) {
+                continue;
+            }
+
+            // create children with the samples at their corners
+            this->children_[level[cell]] = this->children_.size();
+            for (int child = 0; child < corners; ++child) {
+                for (int corner = 0; corner < corners; ++corner) {
+                    int sample = 0;
+                    for (int dim = dimension - 1; dim >= 0; --dim) {
+                        sample = 3 * sample + ((child >> dim) & 1) + ((corner >> dim) & 1);
+                    }
+                    this->values_.push_back(values(cell * samples + sample));
+                }
+
+                for (int dim = 0; dim < dimension; ++dim) {
+                    nextLower(nextLevel.size(), dim) = lower(cell, dim) +
+                        ((child >> dim) & 1 ? 0.5 * size(dim) : 0.0);
+                }
+                nextLevel.push_back(this->children_.size());
+                this->children_.push_back(-1);
+            }
+        }
+
+        level = nextLevel;
+        lower = nextLower.topRows(nextLevel.size());
+    }
+}
+
+int distmesh::cache::Tree::findCell(double const* const point, double* const coordinates,
+    unsigned& depth) const {
+    int const dimension = this->boundingBox_.cols();
+
+    // descend to leaf, using the coordinates to store the lower corner of the cell
+    int cell = 0;
+    depth = 0;
+    for (int dim = 0; dim < dimension; ++dim) {
+        coordinates[dim] = this->boundingBox_(0, dim);
+    }
+    while (this->children_[cell] >= 0) {
+        depth++;
+
+        int child = 0;
+        for (int dim = 0; dim < dimension; ++dim) {
+            double const size = this->cellSizes_(depth, dim);
+            if (point[dim] >= coordinates[dim] + size) {
+                coordinates[dim] += size;
+                child |= 1 << dim;
+            }
+        }
+        cell = this->children_[cell] + child;
+    }
+
+    // local coordinates within cell
+    for (int dim = 0; dim < dimension; ++dim) {
+        coordinates[dim] = (point[dim] - coordinates[dim]) / this->cellSizes_(depth, dim);
+    }
+
+    return cell;
+}
+
+template <
+    class type
+>
+Eigen::Array<type, Eigen::Dynamic, 1> distmesh::cache::Tree::evaluate(
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points) const {
+    int const dimension = this->boundingBox_.cols();
+    std::vector<double> point(dimension), coordinates(dimension);
+    unsigned depth = 0;
+
+    Eigen::Array<type, Eigen::Dynamic, 1> result(points.rows());
+    std::vector<int> outside;
+    for (int row = 0; row < points.rows(); ++row) {
+        bool inside = true;
+        for (int dim = 0; dim < dimension; ++dim) {
+            point[dim] = points(row, dim);
+            inside &= (point[dim] >= this->boundingBox_(0, dim)) &&
+                (point[dim] <= this->boundingBox_(1, dim));
+        }
+
+        if (inside) {
+            int const cell = this->findCell(point.data(), coordinates.data(), depth);
+            result(row) = interpolate(&this->values_[cell << dimension], coordinates.data(),
+                dimension);
+        }
+        else {
+            outside.push_back(row);
+        }
+    }
+
+    // evaluate functional itself outside of bounding box in the precision
+    // of the points
+    if (!outside.empty()) {
+        Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> outsidePoints(outside.size(), dimension);
+        for (size_t row = 0; row < outside.size(); ++row) {
+            outsidePoints.row(row) = points.row(outside[row]);
+        }
+
+        Eigen::Array<type, Eigen::Dynamic, 1> const values = this->functional_(outsidePoints);
+        for (size_t row = 0; row < outside.size(); ++row) {
+            result(outside[row]) = values(row);
+        }
+    }
+
+    return result;
+}
+
+Eigen::ArrayXd distmesh::cache::Tree::operator()(
+    Eigen::Ref<Eigen::ArrayXXd const> const points) const {
+    return this->evaluate<double>(points);
+}
+
+Eigen::ArrayXf distmesh::cache::Tree::operator()(
+    Eigen::Ref<Eigen::ArrayXXf const> const points) const {
+    return this->evaluate<float>(points);
+}
+
+std::tuple<Eigen::ArrayXd, Eigen::ArrayXXd> distmesh::cache::Tree::gradient(
+    Eigen::Ref<Eigen::ArrayXXd const> const points) const {
+    int const dimension = this->boundingBox_.cols();
+    std::vector<double> point(dimension), coordinates(dimension), gradient(dimension);
+    unsigned depth = 0;
+
+    Eigen::ArrayXd result(points.rows());
+    Eigen::ArrayXXd resultGradient(points.rows(), dimension);
+    std::vector<int> outside;
+    for (int row = 0; row < points.rows(); ++row) {
+        bool inside = true;
+        for (int dim = 0; dim < dimension; ++dim) {
+            point[dim] = points(row, dim);
+            inside &= (point[dim] >= this->boundingBox_(0, dim)) &&
+                (point[dim] <= this->boundingBox_(1, dim));
+        }
+
+        // the gradient outside of the bounding box is extrapolated from the
+        // nearest leaf, if the functional does not provide one
+        int const cell = this->findCell(point.data(), coordinates.data(), depth);
+        result(row) = interpolate(&this->values_[cell << dimension], coordinates.data(),
+            dimension, gradient.data());
+        for (int dim = 0; dim < dimension; ++dim) {
+            resultGradient(row, dim) = gradient[dim] / this->cellSizes_(depth, dim);
+        }
+
+        if (!inside) {
+            outside.push_back(row);
+        }
+    }
+
+    // evaluate functional itself outside of bounding box
+    if (!outside.empty()) {
+        Eigen::ArrayXXd outsidePoints(outside.size(), dimension);
+        for (size_t row = 0; row < outside.size(); ++row) {
+            outsidePoints.row(row) = points.row(outside[row]);
+        }
+
+        Eigen::ArrayXd values;
+        Eigen::ArrayXXd gradients;
+        if (this->functional_.hasGradient()) {
+            std::tie(values, gradients) = this->functional_.gradient()(outsidePoints);
+        }
+        else {
+            values = this->functional_(outsidePoints);
+        }
+
+        for (size_t row = 0; row < outside.size(); ++row) {
+            result(outside[row]) = values(row);
+            if (this->functional_.hasGradient()) {
+                resultGradient.row(outside[row]) = gradients.row(row);
+            }
+        }
+    }
+
+    return std::make_tuple(result, resultGradient);
+}
+
+distmesh::cache::Grid::Grid(Functional const& functional,
+    Eigen::Ref<Eigen::ArrayXXd const> const boundingBox, double const spacing,
+    double const gradation)
+    : boundingBox_(boundingBox), shape_(boundingBox.cols()), strides_(boundingBox.cols()),
+    spacing_(boundingBox.cols()) {
+    int const dimension = boundingBox.cols();
+
+    // distribute nodes evenly with at most the given spacing, dimensions without
+    // extent are clamped to a single cell of the given spacing, to avoid a
+    // division by zero for the local coordinates
+    for (int dim = 0; dim < dimension; ++dim) {
+        this->boundingBox_(1, dim) = std::max(boundingBox(1, dim), boundingBox(0, dim));
+        double const extent = this->boundingBox_(1, dim) - this->boundingBox_(0, dim);
+        this->shape_(dim) = std::max(2, (int)std::ceil(extent / spacing) + 1);
+        this->spacing_(dim) = extent > 0.0 ? extent / (this->shape_(dim) - 1) : spacing;
+        this->strides_(dim) = dim == 0 ? 1 : this->strides_(dim - 1) * this->shape_(dim - 1);
+    }
+
+    // sample functional at all nodes
+    Eigen::ArrayXXd nodes(this->shape_.prod(), dimension);
+    for (int node = 0; node < nodes.rows(); ++node)
+    for (int dim = 0; dim < dimension; ++dim) {
+        nodes(node, dim) = boundingBox(0, dim) + this->spacing_(dim) *
+            ((node / this->strides_(dim)) % this->shape_(dim));
+    }
+    this->values_ = functional(nodes);
+
+    if (gradation > 0.0) {
+        this->limitGradation(gradation);
+    }
+}
+
+void distmesh::cache::Grid::limitGradation(double const gradation) {
+    int const dimension = this->shape_.rows();
+    int const neighbours = std::pow(3, dimension);
+
+    // process nodes ordered by their value, similar to fast marching, each
+    // node limits the values of all direct and diagonal neighbours
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>,
+        std::greater<std::pair<double, int>>> queue;
+    for (int node = 0; node < this->values_.rows(); ++node) {
+        queue.push(std::make_pair(this->values_(node), node));
+    }
+
+    while (!queue.empty()) {
+        double const value = queue.top().first;
+        int const node = queue.top().second;
+        queue.pop();
+        if (value > this->values_(node)) {
+            continue;
+        }
+
+        for (int neighbour = 0; neighbour < neighbours; ++neighbour) {
+            int index = node;
+            double distance = 0.0;
+            bool valid = neighbour != (neighbours - 1) / 2;
+            for (int dim = 0, digit = neighbour; valid && (dim < dimension); ++dim, digit /= 3) {
+                int const offset = digit % 3 - 1;
+                int const position = (node / this->strides_(dim)) % this->shape_(dim) + offset;
+
+                valid = (position >= 0) && (position < this->shape_(dim));
+                index += offset * this->strides_(dim);
+                distance += offset != 0 ? this->spacing_(dim) * this->spacing_(dim) : 0.0;
+            }
+
+            if (valid && (value + gradation * std::sqrt(distance) < this->values_(index))) {
+                this->values_(index) = value + gradation * std::sqrt(distance);
+                queue.push(std::make_pair(this->values_(index), index));
+            }
+        }
+    }
+}
+
+template <
+    class type
+>
+Eigen::Array<type, Eigen::Dynamic, 1> distmesh::cache::Grid::evaluate(
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points) const {
+    int const dimension = this->shape_.rows();
+    int const corners = 1 << dimension;
+    std::vector<double> coordinates(dimension), values(corners);
+
+    Eigen::Array<type, Eigen::Dynamic, 1> result(points.rows());
+    for (int row = 0; row < points.rows(); ++row) {
+        // find cell containing point and local coordinates within it
+        int base = 0;
+        for (int dim = 0; dim < dimension; ++dim) {
+            double const position = (std::min(std::max(double(points(row, dim)),
+                this->boundingBox_(0, dim)), this->boundingBox_(1, dim)) -
+                this->boundingBox_(0, dim)) / this->spacing_(dim);
+            int const index = std::min((int)position, this->shape_(dim) - 2);
+
+            coordinates[dim] = position - index;
+            base += index * this->strides_(dim);
+        }
+
+        for (int corner = 0; corner < corners; ++corner) {
+            int node = base;
+            for (int dim = 0; dim < dimension; ++dim) {
+                node += (corner >> dim) & 1 ? this->strides_(dim) : 0;
+            }
+            values[corner] = this->values_(node);
+        }
+        result(row) = interpolate(values.data(), coordinates.data(), dimension);
+    }
+
+    return result;
+}
+
+Eigen::ArrayXd distmesh::cache::Grid::operator()(
+    Eigen::Ref<Eigen::ArrayXXd const> const points) const {
+    return this->evaluate<double>(points);
+}
+
+Eigen::ArrayXf distmesh::cache::Grid::operator()(
+    Eigen::Ref<Eigen::ArrayXXf const> const points) const {
+    return this->evaluate<float>(points);
+}
+
+distmesh::Functional distmesh::cache::backgroundGrid(Functional const& functional,
+    Eigen::Ref<Eigen::ArrayXXd const> const boundingBox, double const spacing,
+    double const gradation) {
+    auto const grid = std::make_shared<Grid const>(functional, boundingBox, spacing, gradation);
+
+    Functional result([=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> Eigen::ArrayXd {
+        return (*grid)(points);
+    });
+    result.single() = [=](Eigen::Ref<Eigen::ArrayXXf const> const points) -> Eigen::ArrayXf {
+        return (*grid)(points);
+    };
+
+    return result;
+}
+
+distmesh::Functional distmesh::cache::adaptive(Functional const& functional,
+    Eigen::Ref<Eigen::ArrayXXd const> const boundingBox, double const tolerance,
+    unsigned const maxDepth, unsigned const minDepth) {
+    auto const tree = std::make_shared<Tree const>(functional, boundingBox, tolerance,
+        maxDepth, minDepth);
+
+    Functional result([=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> Eigen::ArrayXd {
+        return (*tree)(points);
+    }, [=](Eigen::Ref<Eigen::ArrayXXd const> const points)
+        -> std::tuple<Eigen::ArrayXd, Eigen::ArrayXXd> {
+        return tree->gradient(points);
+    });
+    result.single() = [=](Eigen::Ref<Eigen::ArrayXXf const> const points) -> Eigen::ArrayXf {
+        return (*tree)(points);
+    };
+
+    return result;
+}
@@ -18,125 +18,355 @@
 // Contact: patrik.gebhardt@rub.de
 // --------------------------------------------------------------------
 
+#include <limits>
+
 #include "distmesh/distmesh.h"
 
+// parameters identifying a distance function including the shape of all
+// arrays, to allow recognizing identical distance functions within a tape
+static std::vector<double> parameters(
+    std::vector<Eigen::ArrayXXd> const& arrays) {
+    std::vector<double> result;
+    for (auto const& array : arrays) {
+        result.push_back(array.rows());
+        result.push_back(array.cols());
+        result.insert(result.end(), array.data(), array.data() + array.size());
+    }
+
+    return result;
+}
+
+// value and gradient of a distance function
+typedef std::tuple<Eigen::ArrayXd, Eigen::ArrayXXd> dual_t;
+
+// values of the built-in distance functions evaluated in the scalar type
+// of the points, to spare single precision points the cast to double
+template <
+    class type
+>
+static Eigen::Array<type, Eigen::Dynamic, 1> rectangularDistance(
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points,
+    Eigen::ArrayXXd const& rectangle) {
+    Eigen::Array<type, Eigen::Dynamic, 1> result = (points.col(0) - type(rectangle(0, 0)))
+        .min(type(rectangle(1, 0)) - points.col(0));
+
+    for (int dim = 1; dim < points.cols(); ++dim) {
+        result = result
+            .min((points.col(dim) - type(rectangle(0, dim))))
+            .min(type(rectangle(1, dim)) - points.col(dim));
+    }
+
+    return -result;
+}
+
+template <
+    class type
+>
+static Eigen::Array<type, Eigen::Dynamic, 1> rectangleDistance(
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points,
+    Eigen::ArrayXXd const& rectangle) {
+    // distances to all 4 sides of rectangle
+    auto d1 = type(rectangle(0, 1)) - points.col(1);
+    auto d2 = -type(rectangle(1, 1)) + points.col(1);
+    auto d3 = type(rectangle(0, 0)) - points.col(0);
+    auto d4 = -type(rectangle(1, 0)) + points.col(0);
+
+    // distances to all 4 corners of rectangle
+    auto d5 = (d1.square() + d3.square()).sqrt();
+    auto d6 = (d1.square() + d4.square()).sqrt();
+    auto d7 = (d2.square() + d3.square()).sqrt();
+    auto d8 = (d2.square() + d4.square()).sqrt();
+
+    // distance to neares side of rectangle
+    Eigen::Array<type, Eigen::Dynamic, 1> d = -(-d1).min(-d2).min(-d3).min(-d4);
+
+    // check if smallest distance is to one of the corners
+    d = (d1 > type(0) && d3 > type(0)).select(d5, d);
+    d = (d1 > type(0) && d4 > type(0)).select(d6, d);
+    d = (d2 > type(0) && d3 > type(0)).select(d7, d);
+    d = (d2 > type(0) && d4 > type(0)).select(d8, d);
+
+    return d;
+}
+
+template <
+    class type
+>
+static Eigen::Array<type, Eigen::Dynamic, 1> ellipticalDistance(
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points,
+    Eigen::ArrayXd const& _radii, Eigen::ArrayXd const& _midpoint) {
+    Eigen::Array<type, Eigen::Dynamic, 1> const radii = _radii.template cast<type>();
+    Eigen::Array<type, Eigen::Dynamic, 1> const midpoint = _midpoint.template cast<type>();
+
+    if (midpoint.rows() == points.cols()) {
+        if (radii.rows() == points.cols()) {
+            return ((points.rowwise() - midpoint.transpose()).rowwise() / radii.transpose())
+                .square().rowwise().sum().sqrt() - type(1);
+        }
+        else {
+            return (points.rowwise() - midpoint.transpose())
+                .square().rowwise().sum().sqrt() - type(1);
+        }
+    }
+    else {
+        if (radii.rows() == points.cols()) {
+            return (points.rowwise() / radii.transpose())
+                .square().rowwise().sum().sqrt() - type(1);
+        }
+        else {
+            return points.square().rowwise().sum().sqrt() - type(1);
+        }
+    }
+}
+
+template <
+    class type
+>
+static Eigen::Array<type, Eigen::Dynamic, 1> circularDistance(
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points,
+    double const radius, Eigen::ArrayXd const& _midpoint) {
+    Eigen::Array<type, Eigen::Dynamic, 1> const midpoint = _midpoint.template cast<type>();
+
+    if (midpoint.rows() == points.cols()) {
+        return (points.rowwise() - midpoint.transpose())
+            .square().rowwise().sum().sqrt() - type(radius);
+    }
+    else {
+        return points.square().rowwise().sum().sqrt() - type(radius);
+    }
+}
+
+template <
+    class type
+>
+static Eigen::Array<type, Eigen::Dynamic, 1> polygonDistance(
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points,
+    Eigen::ArrayXXd const& polygon) {
+    typedef Eigen::Array<type, Eigen::Dynamic, 1> column_t;
+
+    // distance to nearest point of all polygon sides
+    column_t distance = column_t::Constant(points.rows(),
+        std::numeric_limits<type>::infinity());
+    for (int i = 0, j = polygon.rows() - 1;
+        i < polygon.rows(); j = i++) {
+        type const vx = polygon(i, 0) - polygon(j, 0);
+        type const vy = polygon(i, 1) - polygon(j, 1);
+        type const length = vx * vx + vy * vy;
+
+        column_t const wx = points.col(0) - type(polygon(j, 0));
+        column_t const wy = points.col(1) - type(polygon(j, 1));
+        column_t const t = length > type(0) ?
+            ((wx * vx + wy * vy) / length).max(type(0)).min(type(1)).eval() :
+            column_t::Zero(points.rows()).eval();
+
+        distance = distance.min(((wx - t * vx).square() + (wy - t * vy).square()).sqrt());
+    }
+
+    return (type(1) - type(2) * distmesh::utils::pointsInsidePoly<type>(points, polygon)) *
+        distance;
+}
+
 // creates distance function for a nd rectangular domain
 distmesh::Functional distmesh::distanceFunction::rectangular(
-    Eigen::Ref<Eigen::ArrayXXd const> const rectangle) {
-    return DISTMESH_FUNCTIONAL({
-        Eigen::ArrayXXd result = (points.col(0) - rectangle(0, 0))
-            .min(rectangle(1, 0) - points.col(0));
-
-        for (int dim = 1; dim < points.cols(); ++dim) {
-            result = result
-                .min((points.col(dim) - rectangle(0, dim)))
-                .min(rectangle(1, dim) - points.col(dim));
+    Eigen::Ref<Eigen::ArrayXXd const> const _rectangle) {
+    // copy parameters, which have to outlive the reference
+    Eigen::ArrayXXd const rectangle = _rectangle;
+
+    Functional result([=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> Eigen::ArrayXd {
+        return rectangularDistance<double>(points, rectangle);
+    }, [=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> dual_t {
+        // the gradient points outwards of the nearest side
+        Eigen::ArrayXd result = Eigen::ArrayXd::Constant(points.rows(),
+            std::numeric_limits<double>::infinity());
+        Eigen::ArrayXXd gradient = Eigen::ArrayXXd::Zero(points.rows(), points.cols());
+
+        for (int dim = 0; dim < points.cols(); ++dim) {
+            for (int side = 0; side < 2; ++side) {
+                Eigen::ArrayXd const distance = side == 0 ?
+                    (points.col(dim) - rectangle(0, dim)).eval() :
+                    (rectangle(1, dim) - points.col(dim)).eval();
+                Eigen::Array<bool, Eigen::Dynamic, 1> const nearest = distance < result;
+
+                result = nearest.select(distance, result);
+                for (int i = 0; i < points.cols(); ++i) {
+                    gradient.col(i) = nearest.select(i == dim ? 2.0 * side - 1.0 : 0.0,
+                        gradient.col(i));
+                }
+            }
         }
 
-        return -result;
-    });
+        return dual_t(-result, gradient);
+    }, "rectangular", parameters({ rectangle }));
+    result.single() = [=](Eigen::Ref<Eigen::ArrayXXf const> const points) -> Eigen::ArrayXf {
+        return rectangularDistance<float>(points, rectangle);
+    };
+
+    return result;
 }
 
 // creates the true distance function for a 2d rectangular domain
 distmesh::Functional distmesh::distanceFunction::rectangle(
-    Eigen::Ref<Eigen::ArrayXXd const> const rectangle) {
-    return DISTMESH_FUNCTIONAL({
+    Eigen::Ref<Eigen::ArrayXXd const> const _rectangle) {
+    // copy parameters, which have to outlive the reference
+    Eigen::ArrayXXd const rectangle = _rectangle;
+
+    Functional result([=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> Eigen::ArrayXd {
+        return rectangleDistance<double>(points, rectangle);
+    }, [=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> dual_t {
         // distances to all 4 sides of rectangle
-        auto d1 = rectangle(0, 1) - points.col(1);
-        auto d2 = -rectangle(1, 1) + points.col(1);
-        auto d3 = rectangle(0, 0) - points.col(0);
-        auto d4 = -rectangle(1, 0) + points.col(0);
+        Eigen::ArrayXd const d1 = rectangle(0, 1) - points.col(1);
+        Eigen::ArrayXd const d2 = -rectangle(1, 1) + points.col(1);
+        Eigen::ArrayXd const d3 = rectangle(0, 0) - points.col(0);
+        Eigen::ArrayXd const d4 = -rectangle(1, 0) + points.col(0);
 
         // distances to all 4 corners of rectangle
-        auto d5 = (d1.square() + d3.square()).sqrt();
-        auto d6 = (d1.square() + d4.square()).sqrt();
-        auto d7 = (d2.square() + d3.square()).sqrt();
-        auto d8 = (d2.square() + d4.square()).sqrt();
+        Eigen::ArrayXd const d5 = (d1.square() + d3.square()).sqrt();
+        Eigen::ArrayXd const d6 = (d1.square() + d4.square()).sqrt();
+        Eigen::ArrayXd const d7 = (d2.square() + d3.square()).sqrt();
+        Eigen::ArrayXd const d8 = (d2.square() + d4.square()).sqrt();
 
         // distance to neares side of rectangle
-        Eigen::ArrayXd d = -(-d1).min(-d2).min(-d3).min(-d4);
+        Eigen::ArrayXd d = d1;
+        Eigen::ArrayXXd gradient(points.rows(), 2);
+        gradient.col(0).setZero();
+        gradient.col(1).setConstant(-1.0);
+
+        gradient.col(0) = (d2 > d).select(0.0, gradient.col(0));
+        gradient.col(1) = (d2 > d).select(1.0, gradient.col(1));
+        d = d.max(d2);
+        gradient.col(0) = (d3 > d).select(-1.0, gradient.col(0));
+        gradient.col(1) = (d3 > d).select(0.0, gradient.col(1));
+        d = d.max(d3);
+        gradient.col(0) = (d4 > d).select(1.0, gradient.col(0));
+        gradient.col(1) = (d4 > d).select(0.0, gradient.col(1));
+        d = d.max(d4);
 
         // check if smallest distance is to one of the corners
         d = (d1 > 0.0 && d3 > 0.0).select(d5, d);
+        gradient.col(0) = (d1 > 0.0 && d3 > 0.0).select(-d3 / d5, gradient.col(0));
+        gradient.col(1) = (d1 > 0.0 && d3 > 0.0).select(-d1 / d5, gradient.col(1));
         d = (d1 > 0.0 && d4 > 0.0).select(d6, d);
+        gradient.col(0) = (d1 > 0.0 && d4 > 0.0).select(d4 / d6, gradient.col(0));
+        gradient.col(1) = (d1 > 0.0 && d4 > 0.0).select(-d1 / d6, gradient.col(1));
         d = (d2 > 0.0 && d3 > 0.0).select(d7, d);
+        gradient.col(0) = (d2 > 0.0 && d3 > 0.0).select(-d3 / d7, gradient.col(0));
+        gradient.col(1) = (d2 > 0.0 && d3 > 0.0).select(d2 / d7, gradient.col(1));
         d = (d2 > 0.0 && d4 > 0.0).select(d8, d);
+        gradient.col(0) = (d2 > 0.0 && d4 > 0.0).select(d4 / d8, gradient.col(0));
+        gradient.col(1) = (d2 > 0.0 && d4 > 0.0).select(d2 / d8, gradient.col(1));
 
-        return d;
-    });
+        return dual_t(d, gradient);
+    }, "rectangle", parameters({ rectangle }));
+    result.single() = [=](Eigen::Ref<Eigen::ArrayXXf const> const points) -> Eigen::ArrayXf {
+        return rectangleDistance<float>(points, rectangle);
+    };
+
+    return result;
 }
 
 // creates distance function for elliptical domains
 distmesh::Functional distmesh::distanceFunction::elliptical(
-    Eigen::Ref<Eigen::ArrayXd const> const radii,
-    Eigen::Ref<Eigen::ArrayXd const> const midpoint) {
-    return DISTMESH_FUNCTIONAL({
+    Eigen::Ref<Eigen::ArrayXd const> const _radii,
+    Eigen::Ref<Eigen::ArrayXd const> const _midpoint) {
+    // copy parameters, which have to outlive the reference
+    Eigen::ArrayXd const radii = _radii;
+    Eigen::ArrayXd const midpoint = _midpoint;
+
+    Functional result([=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> Eigen::ArrayXd {
+        return ellipticalDistance<double>(points, radii, midpoint);
+    }, [=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> dual_t {
+        Eigen::ArrayXXd scaledPoints = points;
         if (midpoint.rows() == points.cols()) {
-            if (radii.rows() == points.cols()) {
-                return ((points.rowwise() - midpoint.transpose()).rowwise() / radii.transpose())
-                    .square().rowwise().sum().sqrt() - 1.0;
-            }
-            else {
-                return (points.rowwise() - midpoint.transpose())
-                    .square().rowwise().sum().sqrt() - 1.0;
-            }
+            scaledPoints.rowwise() -= midpoint.transpose();
         }
-        else {
-            if (radii.rows() == points.cols()) {
-                return (points.rowwise() / radii.transpose())
-                    .square().rowwise().sum().sqrt() - 1.0;
-            }
-            else {
-                return points.square().rowwise().sum().sqrt() - 1.0;
-            }
+
+        Eigen::ArrayXXd gradient = scaledPoints;
+        if (radii.rows() == points.cols()) {
+            scaledPoints.rowwise() /= radii.transpose();
+            gradient = scaledPoints.rowwise() / radii.transpose();
         }
-    });
+
+        Eigen::ArrayXd const norm = scaledPoints.square().rowwise().sum().sqrt();
+        return dual_t(norm - 1.0, (norm > 0.0).replicate(1, points.cols()).select(
+            gradient.colwise() / norm, 0.0));
+    }, "elliptical", parameters({ radii, midpoint }));
+    result.single() = [=](Eigen::Ref<Eigen::ArrayXXf const> const points) -> Eigen::ArrayXf {
+        return ellipticalDistance<float>(points, radii, midpoint);
+    };
+
+    return result;
 }
 
 // creates the true distance function for circular domains
 distmesh::Functional
     distmesh::distanceFunction::circular(double const radius,
-    Eigen::Ref<Eigen::ArrayXd const> const midpoint) {
-    return DISTMESH_FUNCTIONAL({
+    Eigen::Ref<Eigen::ArrayXd const> const _midpoint) {
+    // copy parameters, which have to outlive the reference
+    Eigen::ArrayXd const midpoint = _midpoint;
+
+    Functional result([=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> Eigen::ArrayXd {
+        return circularDistance<double>(points, radius, midpoint);
+    }, [=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> dual_t {
+        Eigen::ArrayXXd shiftedPoints = points;
         if (midpoint.rows() == points.cols()) {
-            return (points.rowwise() - midpoint.transpose())
-                .square().rowwise().sum().sqrt() - radius;
-        }
-        else {
-            return points.square().rowwise().sum().sqrt() - radius;
+            shiftedPoints.rowwise() -= midpoint.transpose();
         }
-    });
+
+        Eigen::ArrayXd const norm = shiftedPoints.square().rowwise().sum().sqrt();
+        return dual_t(norm - radius, (norm > 0.0).replicate(1, points.cols()).select(
+            shiftedPoints.colwise() / norm, 0.0));
+    }, "circular", parameters({ Eigen::ArrayXXd::Constant(1, 1, radius), midpoint }));
+    result.single() = [=](Eigen::Ref<Eigen::ArrayXXf const> const points) -> Eigen::ArrayXf {
+        return circularDistance<float>(points, radius, midpoint);
+    };
+
+    return result;
 }
 
 // creates distance function for a 2d domain described by polygon
 distmesh::Functional distmesh::distanceFunction::polygon(
-    Eigen::Ref<Eigen::ArrayXXd const> const polygon) {
-    return DISTMESH_FUNCTIONAL({
-        Eigen::ArrayXXd v(points.rows(), 2);
-        Eigen::ArrayXXd w(points.rows(), 2);
-        Eigen::ArrayXXd c1(points.rows(), 1);
-        Eigen::ArrayXXd c2(points.rows(), 1);
-        Eigen::ArrayXXd distance(points.rows(), polygon.rows());
+    Eigen::Ref<Eigen::ArrayXXd const> const _polygon) {
+    // copy parameters, which have to outlive the reference
+    Eigen::ArrayXXd const polygon = _polygon;
 
+    Functional result([=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> Eigen::ArrayXd {
+        return polygonDistance<double>(points, polygon);
+    }, [=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> dual_t {
+        // distance and direction to nearest point of all polygon sides
+        Eigen::ArrayXd distance = Eigen::ArrayXd::Constant(points.rows(),
+            std::numeric_limits<double>::infinity());
+        Eigen::ArrayXXd gradient = Eigen::ArrayXXd::Zero(points.rows(), 2);
         for (int i = 0, j = polygon.rows() - 1;
             i < polygon.rows(); j = i++) {
-            v.rowwise() = polygon.row(i) - polygon.row(j);
-            w = points.rowwise() - polygon.row(j);
-
-            c1 = v.col(0) * w.col(0) + v.col(1) * w.col(1);
-            c2 = v.col(0) * v.col(0) + v.col(1) * v.col(1);
-
-            distance.col(i) =
-                (c1 <= 0.0).select(
-                    (points.rowwise() - polygon.row(j)).square().rowwise().sum().sqrt(),
-                (c1 >= c2).select(
-                    (points.rowwise() - polygon.row(i)).square().rowwise().sum().sqrt(),
-                    (points - ((v.colwise() * (c1 / c2).col(0)).rowwise() + polygon.row(j)))
-                        .square().rowwise().sum().sqrt()
-                ));
+            double const vx = polygon(i, 0) - polygon(j, 0);
+            double const vy = polygon(i, 1) - polygon(j, 1);
+            double const length = vx * vx + vy * vy;
+
+            Eigen::ArrayXd const wx = points.col(0) - polygon(j, 0);
+            Eigen::ArrayXd const wy = points.col(1) - polygon(j, 1);
+            Eigen::ArrayXd const t = length > 0.0 ?
+                ((wx * vx + wy * vy) / length).max(0.0).min(1.0).eval() :
+                Eigen::ArrayXd::Zero(points.rows()).eval();
+
+            Eigen::ArrayXd const dx = wx - t * vx;
+            Eigen::ArrayXd const dy = wy - t * vy;
+            Eigen::ArrayXd const sideDistance = (dx.square() + dy.square()).sqrt();
+            Eigen::Array<bool, Eigen::Dynamic, 1> const nearest = sideDistance < distance;
+
+            distance = nearest.select(sideDistance, distance);
+            gradient.col(0) = nearest.select(dx, gradient.col(0));
+            gradient.col(1) = nearest.select(dy, gradient.col(1));
         }
 
-        return (1.0 - 2.0 * utils::pointsInsidePoly(points, polygon)) *
-            distance.rowwise().minCoeff();
-    });
+        Eigen::ArrayXd const sign = 1.0 - 2.0 * utils::pointsInsidePoly(points, polygon);
+        gradient = (distance > 0.0).replicate(1, 2).select(
+            gradient.colwise() * (sign / distance), 0.0);
+
+        return dual_t(sign * distance, gradient);
+    }, "polygon", parameters({ polygon }));
+    result.single() = [=](Eigen::Ref<Eigen::ArrayXXf const> const points) -> Eigen::ArrayXf {
+        return polygonDistance<float>(points, polygon);
+    };
+
+    return result;
 }
@@ -21,99 +21,423 @@
 #include <vector>
 #include <set>
 #include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <Eigen/LU>
 
 #include "distmesh/distmesh.h"
 #include "distmesh/constants.h"
 #include "distmesh/triangulation.h"
 
+// wall time in seconds since given time point, which is reset to now
+static double elapsed(std::chrono::steady_clock::time_point& time) {
+    auto const now = std::chrono::steady_clock::now();
+    double const seconds = std::chrono::duration_cast<std::chrono::duration<double>>(
+        now - time).count();
+
+    time = now;
+    return seconds;
+}
+
+// default options given by constants
+distmesh::Options::Options()
+    : solver(Solver::Euler), momentum(constants::momentum), deltaT(constants::deltaT),
+    retriangulationThreshold(constants::retriangulationThreshold),
+    pointsMovementThreshold(constants::pointsMovementThreshold), maxSteps(constants::maxSteps),
+    targetQuality(0.0), qualityPercentile(constants::qualityPercentile),
+    adaptiveTimeStep(false), minDeltaT(constants::minDeltaT), maxDeltaT(constants::maxDeltaT),
+    deltaTGrowth(constants::deltaTGrowth), deltaTReduction(constants::deltaTReduction),
+    incrementalRetriangulation(constants::incrementalRetriangulation), threads(1),
+    seed(0), observer(nullptr) {
+}
+
+// signed volumes of all elements scaled by the factorial of the dimension,
+// using fixed size matrices for two and three dimensions
+template <
+    class type
+>
+static Eigen::ArrayXd signedVolumes(
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points,
+    Eigen::Ref<Eigen::ArrayXXi const> const triangulation) {
+    Eigen::ArrayXd volumes(triangulation.rows());
+    if (points.cols() == 2) {
+        for (int element = 0; element < triangulation.rows(); ++element) {
+            Eigen::Matrix2d const edges = (Eigen::Matrix2d() <<
+                (points.row(triangulation(element, 1)) - points.row(triangulation(element, 0)))
+                    .template cast<double>().matrix(),
+                (points.row(triangulation(element, 2)) - points.row(triangulation(element, 0)))
+                    .template cast<double>().matrix()).finished();
+            volumes(element) = edges.determinant();
+        }
+    }
+    else if (points.cols() == 3) {
+        for (int element = 0; element < triangulation.rows(); ++element) {
+            Eigen::Matrix3d edges;
+            for (int node = 1; node < 4; ++node) {
+                edges.row(node - 1) = (points.row(triangulation(element, node)) -
+                    points.row(triangulation(element, 0))).template cast<double>().matrix();
+            }
+            volumes(element) = edges.determinant();
+        }
+    }
+    else {
+        Eigen::MatrixXd edges(points.cols(), points.cols());
+        for (int element = 0; element < triangulation.rows(); ++element) {
+            for (int node = 1; node < triangulation.cols(); ++node) {
+                edges.row(node - 1) = (points.row(triangulation(element, node)) -
+                    points.row(triangulation(element, 0))).template cast<double>().matrix();
+            }
+            volumes(element) = edges.determinant();
+        }
+    }
+
+    return volumes;
+}
+
 // apply the distmesh algorithm
 std::tuple<Eigen::ArrayXXd, Eigen::ArrayXXi> distmesh::distmesh(
     Functional const& distanceFunction, double const initialPointDistance,
     Functional const& elementSizeFunction, Eigen::Ref<Eigen::ArrayXXd const> const boundingBox,
-    Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints) {
+    Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints, unsigned const threads) {
+    Options options;
+    options.threads = threads;
+
+    return distmesh(distanceFunction, initialPointDistance, elementSizeFunction,
+        boundingBox, fixedPoints, options);
+}
+
+// apply the distmesh algorithm with the given options
+std::tuple<Eigen::ArrayXXd, Eigen::ArrayXXi> distmesh::distmesh(
+    Functional const& distanceFunction, double const initialPointDistance,
+    Functional const& elementSizeFunction, Eigen::Ref<Eigen::ArrayXXd const> const boundingBox,
+    Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints, Options const& options,
+    Statistics* const statistics) {
+    triangulation::Triangulator triangulator;
+    return distmesh(triangulator, distanceFunction, initialPointDistance,
+        elementSizeFunction, boundingBox, fixedPoints, options, statistics);
+}
+
+// apply the distmesh algorithm using the given triangulator
+std::tuple<Eigen::ArrayXXd, Eigen::ArrayXXi> distmesh::distmesh(
+    triangulation::Triangulator& triangulator,
+    Functional const& distanceFunction, double const initialPointDistance,
+    Functional const& elementSizeFunction, Eigen::Ref<Eigen::ArrayXXd const> const boundingBox,
+    Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints, Options const& options,
+    Statistics* const statistics) {
+    return distmesh<double>(triangulator, distanceFunction, initialPointDistance,
+        elementSizeFunction, boundingBox, fixedPoints, options, statistics);
+}
+
+// apply the distmesh algorithm using the given scalar type for points and forces
+template <
+    class type
+>
+std::tuple<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic>, Eigen::ArrayXXi> distmesh::distmesh(
+    triangulation::Triangulator& triangulator,
+    Functional const& distanceFunction, double const initialPointDistance,
+    Functional const& elementSizeFunction, Eigen::Ref<Eigen::ArrayXXd const> const boundingBox,
+    Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints, Options const& options,
+    Statistics* const statistics) {
+    return BasicMesher<type>(options)(triangulator, distanceFunction, initialPointDistance,
+        elementSizeFunction, boundingBox, fixedPoints, statistics);
+}
+
+template <
+    class type
+>
+distmesh::BasicMesher<type>::BasicMesher(Options const& options)
+    : options_(options) {
+}
+
+// view of the workspace with the given size, its capacity only grows
+template <
+    class type
+>
+template <
+    class scalar
+>
+Eigen::Map<Eigen::Array<scalar, Eigen::Dynamic, Eigen::Dynamic>>
+    distmesh::BasicMesher<type>::workspace(std::vector<scalar>& buffer,
+    Eigen::Index const rows, Eigen::Index const cols) {
+    if (buffer.size() < static_cast<size_t>(rows * cols)) {
+        buffer.resize(rows * cols);
+    }
+
+    return Eigen::Map<Eigen::Array<scalar, Eigen::Dynamic, Eigen::Dynamic>>(
+        buffer.data(), rows, cols);
+}
+
+template <
+    class type
+>
+std::tuple<typename distmesh::BasicMesher<type>::array_t, Eigen::ArrayXXi>
+    distmesh::BasicMesher<type>::operator()(
+    Functional const& distanceFunction, double const initialPointDistance,
+    Functional const& elementSizeFunction, Eigen::Ref<Eigen::ArrayXXd const> const boundingBox,
+    Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints, Statistics* const statistics) {
+    return (*this)(this->triangulator_, distanceFunction, initialPointDistance,
+        elementSizeFunction, boundingBox, fixedPoints, statistics);
+}
+
+// apply the distmesh algorithm reusing the workspaces of previous runs, all
+// casts to double precision are no-ops for the double precision instantiation
+template <
+    class type
+>
+std::tuple<typename distmesh::BasicMesher<type>::array_t, Eigen::ArrayXXi>
+    distmesh::BasicMesher<type>::operator()(triangulation::Triangulator& triangulator,
+    Functional const& distanceFunction, double const initialPointDistance,
+    Functional const& elementSizeFunction, Eigen::Ref<Eigen::ArrayXXd const> const boundingBox,
+    Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints, Statistics* const statistics) {
+    auto const& options = this->options_;
+
     // determine dimension of mesh
     unsigned const dimension = boundingBox.cols();
 
+    // the radius ratio is only defined for triangles and tetrahedra
+    if ((options.targetQuality > 0.0) && (dimension != 2) && (dimension != 3)) {
+        throw std::invalid_argument(
+            "distmesh: quality based stopping requires two or three dimensions");
+    }
+
     // create initial distribution in bounding box
-    Eigen::ArrayXXd points = utils::createInitialPoints(distanceFunction,
-        initialPointDistance, elementSizeFunction, boundingBox, fixedPoints);
+    Statistics runStatistics;
+    auto start = std::chrono::steady_clock::now();
+    auto time = start;
+    Eigen::ArrayXXd const initialPoints = utils::createInitialPoints(distanceFunction,
+        initialPointDistance, elementSizeFunction, boundingBox, fixedPoints, options.threads,
+        options.seed);
+    auto points = workspace(this->points_, initialPoints.rows(), dimension);
+    points = initialPoints.template cast<type>();
+    runStatistics.initializationTime = elapsed(time);
 
-    // create initial triangulation
-    Eigen::ArrayXXi triangulation = triangulation::delaunay(points);
+    // full delaunay triangulation of all points, which is kept to be updated
+    // incrementally, the triangulation restricted to the domain and its edges
+    // are stored in workspaces given by their number of rows
+    int delaunayCount = 0, triangleCount = 0, edgeCount = 0;
 
     // create buffer to store old point locations to calculate
     // retriangulation and stop criterion
-    Eigen::ArrayXXd retriangulationCriterionBuffer = Eigen::ArrayXXd::Constant(
-        points.rows(), points.cols(), INFINITY);
-    Eigen::ArrayXXd stopCriterionBuffer = Eigen::ArrayXXd::Zero(
-        points.rows(), points.cols());
+    auto retriangulationCriterionBuffer = workspace(this->retriangulationCriterionBuffer_,
+        points.rows(), dimension);
+    auto stopCriterionBuffer = workspace(this->stopCriterionBuffer_, points.rows(), dimension);
+    retriangulationCriterionBuffer.setConstant(INFINITY);
+
+    // the movement of the current and the previous step are stored alternately
+    // in both movement workspaces
+    workspace(this->movement_[0], points.rows(), dimension);
+    workspace(this->movement_[1], points.rows(), dimension).setZero();
+
+    // no edges are connected to any node before the first triangulation
+    workspace(this->nodeEdgeOffsets_, points.rows() + 1, 1).setZero();
 
     // main distmesh loop
-    Eigen::ArrayXXi edgeIndices;
-    for (unsigned step = 0; step < constants::maxSteps; ++step) {
-        // retriangulate if point movement is above threshold
-        if ((points - retriangulationCriterionBuffer).square().rowwise().sum().sqrt().maxCoeff() >
-            constants::retriangulationThreshold * initialPointDistance) {
-            // update triangulation
-            triangulation = triangulation::delaunay(points);
+    double deltaT = options.deltaT;
+    double previousResidual = INFINITY;
+    for (unsigned step = 0; step < options.maxSteps; ++step) {
+        workspace_t movement(this->movement_[step % 2].data(), points.rows(), dimension);
+        workspace_t previousMovement(this->movement_[(step + 1) % 2].data(),
+            points.rows(), dimension);
+        Iteration iteration;
+        iteration.step = step;
+        time = std::chrono::steady_clock::now();
+
+        // store current points positions and extrapolate them by their
+        // previous movement for the accelerated solver
+        stopCriterionBuffer = points;
+        if (options.solver == Solver::Nesterov) {
+            points += type(options.momentum) * previousMovement;
+        }
+
+        // retriangulate if point movement is above threshold, compare squared
+        // distances, since the vectorized single precision square root of
+        // the initial infinite distance is not a number
+        if ((points - retriangulationCriterionBuffer).square().rowwise().sum().maxCoeff() >
+            std::pow(options.retriangulationThreshold * initialPointDistance, 2)) {
+            // update triangulation locally by edge flips, if possible,
+            // otherwise fall back to a complete retriangulation
+            auto previousTriangulation = workspace(this->delaunayTriangulation_, delaunayCount,
+                dimension + 1);
+            if (!options.incrementalRetriangulation || (delaunayCount == 0) ||
+                !triangulation::updateDelaunay<type>(points, retriangulationCriterionBuffer,
+                    previousTriangulation)) {
+                // qhull only supports points in double precision
+                Eigen::ArrayXXi const delaunay = triangulator.delaunay(points.template cast<double>());
+                delaunayCount = delaunay.rows();
+                workspace(this->delaunayTriangulation_, delaunayCount, dimension + 1) = delaunay;
+            }
+            auto const delaunayTriangulation = workspace(this->delaunayTriangulation_,
+                delaunayCount, dimension + 1);
+            iteration.retriangulated = true;
 
             // reject triangles with circumcenter outside of the region
-            Eigen::ArrayXXd circumcenter = Eigen::ArrayXXd::Zero(triangulation.rows(), dimension);
-            for (int point = 0; point < triangulation.cols(); ++point) {
-                circumcenter += utils::selectIndexedArrayElements<double>(
-                    points, triangulation.col(point)) / triangulation.cols();
+            auto circumcenter = workspace(this->centroids_, delaunayCount, dimension);
+            circumcenter.setZero();
+            for (int point = 0; point < delaunayTriangulation.cols(); ++point)
+            for (int element = 0; element < delaunayCount; ++element) {
+                circumcenter.row(element) += points.row(delaunayTriangulation(element, point)) /
+                    type(delaunayTriangulation.cols());
             }
-            triangulation = utils::selectMaskedArrayElements<int>(triangulation,
-                distanceFunction(circumcenter) < -constants::geometryEvaluationThreshold * initialPointDistance);
+            Eigen::Array<type, Eigen::Dynamic, 1> const distance = distanceFunction(circumcenter);
+            type const threshold = -constants::geometryEvaluationThreshold * initialPointDistance;
+            triangleCount = (distance < threshold).count();
+            auto triangulation = workspace(this->triangulation_, triangleCount, dimension + 1);
+            for (int element = 0, row = 0; element < delaunayCount; ++element) {
+                if (distance(element) < threshold) {
+                    triangulation.row(row++) = delaunayTriangulation.row(element);
+                }
+            }
+            iteration.delaunayTime = elapsed(time);
 
-            // find unique edge indices
-            edgeIndices = utils::findUniqueEdges(triangulation);
+            // find unique edge indices and the edges connected to each node
+            edgeCount = utils::findUniqueEdges(triangulation, this->edgeIndices_,
+                this->edgeKeys_, options.threads);
+            utils::nodeEdgeAdjacency(workspace(this->edgeIndices_, edgeCount, 2), points.rows(),
+                this->nodeEdgeOffsets_, this->nodeEdges_);
 
             // store current points positions
             retriangulationCriterionBuffer = points;
+            iteration.edgeTime = elapsed(time);
         }
+        auto const triangulation = workspace(this->triangulation_, triangleCount, dimension + 1);
+        auto const edgeIndices = workspace(this->edgeIndices_, edgeCount, 2);
+        auto const nodeEdgeOffsets = workspace(this->nodeEdgeOffsets_, points.rows() + 1, 1).col(0);
+        auto const nodeEdges = workspace(this->nodeEdges_, 2 * edgeCount, 1).col(0);
+        iteration.edgeCount = edgeIndices.rows();
 
-        // calculate edge vectors and their length
-        auto const edgeVector = (utils::selectIndexedArrayElements<double>(points, edgeIndices.col(0)) -
-            utils::selectIndexedArrayElements<double>(points, edgeIndices.col(1))).eval();
-        auto const edgeLength = edgeVector.square().rowwise().sum().sqrt().eval();
+        // calculate edge vectors, their length and midpoints
+        auto edgeVector = workspace(this->edgeVector_, edgeIndices.rows(), dimension);
+        auto edgeMidpoint = workspace(this->edgeMidpoint_, edgeIndices.rows(), dimension);
+        auto edgeLength = workspace(this->edgeLength_, edgeIndices.rows(), 1).col(0);
+        utils::edgeGeometry<type>(points, edgeIndices, edgeVector, edgeLength, edgeMidpoint);
 
-        // evaluate elementSizeFunction at midpoints of edges
-        auto const desiredElementSize = elementSizeFunction(0.5 *
-            (utils::selectIndexedArrayElements<double>(points, edgeIndices.col(0)) +
-            utils::selectIndexedArrayElements<double>(points, edgeIndices.col(1)))).eval();
+        // evaluate elementSizeFunction at midpoints of edges in the precision
+        // of the points, if the functional supports it
+        Eigen::Array<type, Eigen::Dynamic, 1> const desiredElementSize =
+            elementSizeFunction(edgeMidpoint);
 
-        // calculate desired edge length
-        auto const desiredEdgeLength = (desiredElementSize * (1.0 + 0.4 / std::pow(2.0, dimension - 1)) *
-            std::pow((edgeLength.pow(dimension).sum() / desiredElementSize.pow(dimension).sum()),
-                1.0 / dimension)).eval();
+        // calculate relative difference of desired and actual edge length,
+        // summing up the edge lengths and element sizes in double precision
+        double const scale = std::pow((edgeLength.template cast<double>().pow(dimension).sum() /
+            desiredElementSize.template cast<double>().pow(dimension).sum()), 1.0 / dimension);
+        auto edgeForce = workspace(this->edgeForce_, edgeIndices.rows(), 1).col(0);
+        edgeForce = (desiredElementSize * type(1.0 + 0.4 / std::pow(2.0, dimension - 1)) *
+            type(scale) - edgeLength) / edgeLength;
 
-        // calculate force vector for each edge
-        auto const forceVector = (edgeVector.colwise() *
-            ((desiredEdgeLength - edgeLength) / edgeLength).max(0.0)).eval();
+        // calculate force vector for each edge in place of the edge vectors
+        auto& forceVector = edgeVector;
+        forceVector.colwise() *= edgeForce.max(type(0));
 
-        // store current points positions
-        stopCriterionBuffer = points;
+        // move all points, which are not fixed
+        utils::accumulateForces<type>(forceVector, nodeEdgeOffsets, nodeEdges,
+            deltaT, fixedPoints.rows(), points, options.threads);
+        iteration.forceTime = elapsed(time);
 
-        // move points
-        for (int edge = 0; edge < edgeIndices.rows(); ++edge) {
-            if (edgeIndices(edge, 0) >= fixedPoints.rows()) {
-                points.row(edgeIndices(edge, 0)) += constants::deltaT * forceVector.row(edge);
+        // project points outside of domain to boundary
+        utils::projectPointsToBoundary<type>(distanceFunction, initialPointDistance, points);
+        iteration.projectionTime = elapsed(time);
+
+        // reject accelerated step, when any element got inverted due to the
+        // extrapolation, elements of a triangulation created from the extrapolated
+        // points may already be inverted at the stored positions, so steps which
+        // retriangulated are never rejected, degenerated elements are ignored,
+        // the rejected points are retriangulated in the next step
+        bool const rejected = (options.solver == Solver::Nesterov) &&
+            !iteration.retriangulated && !previousMovement.isZero(0.0) &&
+            (signedVolumes<type>(stopCriterionBuffer, triangulation) *
+                signedVolumes<type>(points, triangulation) < 0.0).any();
+        if (rejected) {
+            points = stopCriterionBuffer;
+            retriangulationCriterionBuffer.setConstant(INFINITY);
+        }
+
+        // the residual is given by the root mean square of the effective
+        // forces, i.e. the points movement including the projection, all
+        // criteria are accumulated in double precision
+        movement = points - stopCriterionBuffer;
+        iteration.maxMovement = std::sqrt(movement.template cast<double>()
+            .square().rowwise().sum().maxCoeff());
+        iteration.deltaT = deltaT;
+        iteration.residual = std::sqrt(movement.template cast<double>().square().sum() /
+            points.rows()) / deltaT;
+
+        // on oscillation, i.e. when the points move against their previous
+        // movement, reduce the time step, otherwise grow the time step while
+        // the residual decreases
+        bool const oscillation = (movement.template cast<double>() *
+            previousMovement.template cast<double>()).sum() < 0.0;
+        if (options.adaptiveTimeStep && !rejected) {
+            if (oscillation) {
+                deltaT = std::max(deltaT * options.deltaTReduction, options.minDeltaT);
             }
-            if (edgeIndices(edge, 1) >= fixedPoints.rows()) {
-                points.row(edgeIndices(edge, 1)) -= constants::deltaT * forceVector.row(edge);
+            else if (iteration.residual < previousResidual) {
+                deltaT = std::min(deltaT * options.deltaTGrowth, options.maxDeltaT);
             }
         }
+        if (!rejected) {
+            previousResidual = iteration.residual;
+        }
 
-        // project points outside of domain to boundary
-        utils::projectPointsToBoundary(distanceFunction, initialPointDistance, points);
+        // reset momentum of accelerated solver on oscillation or rejected steps,
+        // the movement becomes the previous movement of the next step
+        if (rejected || ((options.solver == Solver::Nesterov) && oscillation)) {
+            movement.setZero();
+            iteration.restarted = true;
+        }
+
+        // evaluate quality of the elements for quality based stopping
+        if (options.targetQuality > 0.0) {
+            iteration.quality = quality::percentile(quality::radiusRatio(
+                points.template cast<double>(), triangulation), options.qualityPercentile);
+        }
+
+        // accumulate statistics and notify observer
+        runStatistics.steps++;
+        runStatistics.retriangulations += iteration.retriangulated ? 1 : 0;
+        runStatistics.restarts += iteration.restarted ? 1 : 0;
+        runStatistics.maxMovement = iteration.maxMovement;
+        runStatistics.edgeCount = iteration.edgeCount;
+        runStatistics.quality = iteration.quality;
+        runStatistics.delaunayTime += iteration.delaunayTime;
+        runStatistics.edgeTime += iteration.edgeTime;
+        runStatistics.forceTime += iteration.forceTime;
+        runStatistics.projectionTime += iteration.projectionTime;
+        if (options.observer != nullptr) {
+            options.observer(iteration);
+        }
 
-        // stop, when maximum points movement is below threshold
-        if ((points - stopCriterionBuffer).square().rowwise().sum().sqrt().maxCoeff() <
-            constants::pointsMovementThreshold * initialPointDistance) {
+        // stop, when maximum points movement is below threshold, the movement
+        // is scaled to the initial time step, to keep the criterion independent
+        // of the adaptive time step, rejected steps never converge
+        if (!rejected &&
+            iteration.maxMovement * options.deltaT / iteration.deltaT <
+            options.pointsMovementThreshold * initialPointDistance) {
             break;
         }
+
+        // stop, when the mesh is good enough
+        if (!rejected && (options.targetQuality > 0.0) &&
+            (iteration.quality >= options.targetQuality)) {
+            break;
+        }
+    }
+
+    runStatistics.totalTime = elapsed(start);
+    if (statistics != nullptr) {
+        *statistics = runStatistics;
     }
 
-    return std::make_tuple(points, triangulation);
+    return std::make_tuple(array_t(points), Eigen::ArrayXXi(
+        workspace(this->triangulation_, triangleCount, dimension + 1)));
 }
+
+template std::tuple<Eigen::ArrayXXf, Eigen::ArrayXXi> distmesh::distmesh<float>(
+    triangulation::Triangulator&, Functional const&, double const, Functional const&,
+    Eigen::Ref<Eigen::ArrayXXd const> const, Eigen::Ref<Eigen::ArrayXXd const> const,
+    Options const&, Statistics* const);
+template std::tuple<Eigen::ArrayXXd, Eigen::ArrayXXi> distmesh::distmesh<double>(
+    triangulation::Triangulator&, Functional const&, double const, Functional const&,
+    Eigen::Ref<Eigen::ArrayXXd const> const, Eigen::Ref<Eigen::ArrayXXd const> const,
+    Options const&, Statistics* const);
+template class distmesh::BasicMesher<float>;
+template class distmesh::BasicMesher<double>;
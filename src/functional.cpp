@@ -20,15 +20,171 @@
 
 #include "distmesh/distmesh.h"
 
+// macro for easier creation of std functions
+#define DISTMESH_FUNCTION(function_body) \
+    (distmesh::Functional::function_t([=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> Eigen::ArrayXd \
+        function_body))
+
+// value and gradient of a functional
+typedef std::tuple<Eigen::ArrayXd, Eigen::ArrayXXd> dual_t;
+
+// propagate the gradient of a single operand by the given rule, the result
+// provides no gradient, if the operand does not
+template <
+    class Rule
+>
+static distmesh::Functional::gradient_t propagate(distmesh::Functional const& operand,
+    Rule const& rule) {
+    if (!operand.hasGradient()) {
+        return nullptr;
+    }
+
+    auto const gradient = operand.gradient();
+    return [=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> dual_t {
+        auto const dual = gradient(points);
+        return rule(std::get<0>(dual), std::get<1>(dual));
+    };
+}
+
+// propagate the gradients of both operands by the given rule
+template <
+    class Rule
+>
+static distmesh::Functional::gradient_t propagate(distmesh::Functional const& lhs,
+    distmesh::Functional const& rhs, Rule const& rule) {
+    if (!lhs.hasGradient() || !rhs.hasGradient()) {
+        return nullptr;
+    }
+
+    auto const lhsGradient = lhs.gradient();
+    auto const rhsGradient = rhs.gradient();
+    return [=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> dual_t {
+        auto const lhsDual = lhsGradient(points);
+        auto const rhsDual = rhsGradient(points);
+        return rule(std::get<0>(lhsDual), std::get<1>(lhsDual),
+            std::get<0>(rhsDual), std::get<1>(rhsDual));
+    };
+}
+
+// combine the single precision evaluation of a single operand by the given
+// rule, the result provides none, if the operand does not
+template <
+    class Rule
+>
+static distmesh::Functional::single_t combine(distmesh::Functional const& operand,
+    Rule const& rule) {
+    if (!operand.hasSingle()) {
+        return nullptr;
+    }
+
+    auto const single = operand.single();
+    return [=](Eigen::Ref<Eigen::ArrayXXf const> const points) -> Eigen::ArrayXf {
+        return rule(single(points));
+    };
+}
+
+// combine the single precision evaluations of both operands by the given rule
+template <
+    class Rule
+>
+static distmesh::Functional::single_t combine(distmesh::Functional const& lhs,
+    distmesh::Functional const& rhs, Rule const& rule) {
+    if (!lhs.hasSingle() || !rhs.hasSingle()) {
+        return nullptr;
+    }
+
+    auto const lhsSingle = lhs.single();
+    auto const rhsSingle = rhs.single();
+    return [=](Eigen::Ref<Eigen::ArrayXXf const> const points) -> Eigen::ArrayXf {
+        return rule(lhsSingle(points), rhsSingle(points));
+    };
+}
+
+// evaluate the single precision evaluation of the operand at the points
+// transformed by the given rule, the result provides none, if the operand does not
+template <
+    class Rule
+>
+static distmesh::Functional::single_t transform(distmesh::Functional const& operand,
+    Rule const& rule) {
+    if (!operand.hasSingle()) {
+        return nullptr;
+    }
+
+    auto const single = operand.single();
+    return [=](Eigen::Ref<Eigen::ArrayXXf const> const points) -> Eigen::ArrayXf {
+        return single(rule(points));
+    };
+}
+
+// attach single precision evaluation to functional
+static distmesh::Functional withSingle(distmesh::Functional functional,
+    distmesh::Functional::single_t const& single) {
+    functional.single() = single;
+    return functional;
+}
+
+// create node of symbolic description
+static std::shared_ptr<distmesh::tape::Node const> createNode(
+    distmesh::tape::Operation const operation,
+    std::shared_ptr<distmesh::tape::Node const> const& lhs,
+    std::shared_ptr<distmesh::tape::Node const> const& rhs=nullptr,
+    std::vector<double> const& parameters=std::vector<double>()) {
+    std::vector<std::shared_ptr<distmesh::tape::Node const>> operands(1, lhs);
+    if (rhs != nullptr) {
+        operands.push_back(rhs);
+    }
+
+    return std::make_shared<distmesh::tape::Node const>(operation, operands, parameters);
+}
+
+// create node of symbolic description of a constant
+static std::shared_ptr<distmesh::tape::Node const> createConstant(double const constant) {
+    return std::make_shared<distmesh::tape::Node const>(distmesh::tape::Operation::Constant,
+        std::vector<std::shared_ptr<distmesh::tape::Node const>>(), std::vector<double>(1, constant));
+}
+
+// create class from function type, which is only identical to itself
+distmesh::Functional::Functional(function_t const& func, gradient_t const& gradient)
+    : function_(func), gradient_(gradient), node_(std::make_shared<tape::Node const>(
+        tape::Operation::Function, std::vector<std::shared_ptr<tape::Node const>>(),
+        std::vector<double>(), "", func)) {
+}
+
+distmesh::Functional::Functional(double const constant)
+    : function_(DISTMESH_FUNCTION({
+        return Eigen::ArrayXd::Constant(points.rows(), constant);
+    })), gradient_([=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> dual_t {
+        return std::make_tuple(Eigen::ArrayXd::Constant(points.rows(), constant).eval(),
+            Eigen::ArrayXXd::Zero(points.rows(), points.cols()).eval());
+    }), single_([=](Eigen::Ref<Eigen::ArrayXXf const> const points) -> Eigen::ArrayXf {
+        return Eigen::ArrayXf::Constant(points.rows(), constant);
+    }), node_(createConstant(constant)) {
+}
+
+// create class from function type identified by name and parameters
+distmesh::Functional::Functional(function_t const& func, gradient_t const& gradient,
+    std::string const& name, std::vector<double> const& parameters)
+    : function_(func), gradient_(gradient), node_(std::make_shared<tape::Node const>(
+        tape::Operation::Function, std::vector<std::shared_ptr<tape::Node const>>(),
+        parameters, name, func)) {
+}
+
 // assignment operator
 distmesh::Functional& distmesh::Functional::operator=(
     Functional const& rhs) {
     this->function() = rhs.function();
+    this->gradient() = rhs.gradient();
+    this->single() = rhs.single();
+    this->node_ = rhs.node();
     return *this;
 }
 distmesh::Functional& distmesh::Functional::operator=(
     Functional&& rhs) {
     this->function() = std::move(rhs.function());
+    this->gradient() = std::move(rhs.gradient());
+    this->single() = std::move(rhs.single());
+    this->node_ = std::move(rhs.node_);
     return *this;
 }
 
@@ -37,208 +193,318 @@ Eigen::ArrayXd distmesh::Functional::operator()(
     return this->function()(points);
 }
 
+Eigen::ArrayXf distmesh::Functional::operator()(
+    Eigen::Ref<Eigen::ArrayXXf const> const points) const {
+    if (this->hasSingle()) {
+        return this->single()(points);
+    }
+
+    return this->function()(points.cast<double>()).cast<float>();
+}
+
 distmesh::Functional distmesh::Functional::operator-() const {
-    auto const func = this->function();;
-    return DISTMESH_FUNCTIONAL({
+    auto const func = this->function();
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return -func(points);
-    });
+    }), propagate(*this, [](Eigen::ArrayXd const& value, Eigen::ArrayXXd const& gradient) {
+        return dual_t(-value, -gradient);
+    }), createNode(tape::Operation::Negate, this->node())),
+    combine(*this, [](Eigen::ArrayXf const& value) {
+        return (-value).eval();
+    }));
 }
 
 distmesh::Functional& distmesh::Functional::operator+=(
     Functional const& rhs) {
-    auto const func = this->function();
-    this->function() = DISTMESH_FUNCTIONAL({
-        return func(points) + rhs(points);
-    });
+    *this = *this + rhs;
     return *this;
 }
 
 distmesh::Functional& distmesh::Functional::operator+=(
     double const rhs) {
-    auto const func = this->function();
-    this->function() = DISTMESH_FUNCTIONAL({
-        return func(points) + rhs;
-    });
+    *this = *this + rhs;
     return *this;
 }
 
 distmesh::Functional& distmesh::Functional::operator-=(
     Functional const& rhs) {
-    auto const func = this->function();
-    this->function() = DISTMESH_FUNCTIONAL({
-        return func(points) - rhs(points);
-    });
+    *this = *this - rhs;
     return *this;
 }
 
 distmesh::Functional& distmesh::Functional::operator-=(
     double const rhs) {
-    auto const func = this->function();
-    this->function() = DISTMESH_FUNCTIONAL({
-        return func(points) - rhs;
-    });
+    *this = *this - rhs;
     return *this;
 }
 
 distmesh::Functional& distmesh::Functional::operator*=(
     Functional const& rhs) {
-    auto const func = this->function();
-    this->function() = DISTMESH_FUNCTIONAL({
-        return func(points) * rhs(points);
-    });
+    *this = *this * rhs;
     return *this;
 }
 
 distmesh::Functional& distmesh::Functional::operator*=(
     double const rhs) {
-    auto const func = this->function();
-    this->function() = DISTMESH_FUNCTIONAL({
-        return func(points) * rhs;
-    });
+    *this = *this * rhs;
     return *this;
 }
 
 distmesh::Functional& distmesh::Functional::operator/=(
     Functional const& rhs) {
-    auto const func = this->function();
-    this->function() = DISTMESH_FUNCTIONAL({
-        return func(points) / rhs(points);
-    });
+    *this = *this / rhs;
     return *this;
 }
 
 distmesh::Functional& distmesh::Functional::operator/=(
     double const rhs) {
-    auto const func = this->function();
-    this->function() = DISTMESH_FUNCTIONAL({
-        return func(points) / rhs;
-    });
+    *this = *this / rhs;
     return *this;
 }
 
 distmesh::Functional distmesh::operator+(
     Functional const& lhs, Functional const& rhs) {
-    return DISTMESH_FUNCTIONAL({
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return lhs(points) + rhs(points);
-    });
+    }), propagate(lhs, rhs, [](Eigen::ArrayXd const& lhsValue, Eigen::ArrayXXd const& lhsGradient,
+        Eigen::ArrayXd const& rhsValue, Eigen::ArrayXXd const& rhsGradient) {
+        return dual_t(lhsValue + rhsValue, lhsGradient + rhsGradient);
+    }), createNode(tape::Operation::Add, lhs.node(), rhs.node())),
+    combine(lhs, rhs, [](Eigen::ArrayXf const& lhsValue, Eigen::ArrayXf const& rhsValue) {
+        return (lhsValue + rhsValue).eval();
+    }));
 }
 
 distmesh::Functional distmesh::operator+(
     Functional const& lhs, double const rhs) {
-    return DISTMESH_FUNCTIONAL({
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return lhs(points) + rhs;
-    });
+    }), propagate(lhs, [=](Eigen::ArrayXd const& value, Eigen::ArrayXXd const& gradient) {
+        return dual_t(value + rhs, gradient);
+    }), createNode(tape::Operation::Add, lhs.node(), createConstant(rhs))),
+    combine(lhs, [=](Eigen::ArrayXf const& value) {
+        return (value + float(rhs)).eval();
+    }));
 }
 
 distmesh::Functional distmesh::operator+(
     double const lhs, Functional const& rhs) {
-    return DISTMESH_FUNCTIONAL({
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return lhs + rhs(points);
-    });
+    }), propagate(rhs, [=](Eigen::ArrayXd const& value, Eigen::ArrayXXd const& gradient) {
+        return dual_t(lhs + value, gradient);
+    }), createNode(tape::Operation::Add, createConstant(lhs), rhs.node())),
+    combine(rhs, [=](Eigen::ArrayXf const& value) {
+        return (float(lhs) + value).eval();
+    }));
 }
 
 distmesh::Functional distmesh::operator-(
     Functional const& lhs, Functional const& rhs) {
-    return DISTMESH_FUNCTIONAL({
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return lhs(points) - rhs(points);
-    });
+    }), propagate(lhs, rhs, [](Eigen::ArrayXd const& lhsValue, Eigen::ArrayXXd const& lhsGradient,
+        Eigen::ArrayXd const& rhsValue, Eigen::ArrayXXd const& rhsGradient) {
+        return dual_t(lhsValue - rhsValue, lhsGradient - rhsGradient);
+    }), createNode(tape::Operation::Subtract, lhs.node(), rhs.node())),
+    combine(lhs, rhs, [](Eigen::ArrayXf const& lhsValue, Eigen::ArrayXf const& rhsValue) {
+        return (lhsValue - rhsValue).eval();
+    }));
 }
 
 distmesh::Functional distmesh::operator-(
     Functional const& lhs, double const rhs) {
-    return DISTMESH_FUNCTIONAL({
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return lhs(points) - rhs;
-    });
+    }), propagate(lhs, [=](Eigen::ArrayXd const& value, Eigen::ArrayXXd const& gradient) {
+        return dual_t(value - rhs, gradient);
+    }), createNode(tape::Operation::Subtract, lhs.node(), createConstant(rhs))),
+    combine(lhs, [=](Eigen::ArrayXf const& value) {
+        return (value - float(rhs)).eval();
+    }));
 }
 
 distmesh::Functional distmesh::operator-(
     double const lhs, Functional const& rhs) {
-    return DISTMESH_FUNCTIONAL({
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return lhs - rhs(points);
-    });
+    }), propagate(rhs, [=](Eigen::ArrayXd const& value, Eigen::ArrayXXd const& gradient) {
+        return dual_t(lhs - value, -gradient);
+    }), createNode(tape::Operation::Subtract, createConstant(lhs), rhs.node())),
+    combine(rhs, [=](Eigen::ArrayXf const& value) {
+        return (float(lhs) - value).eval();
+    }));
 }
 
 distmesh::Functional distmesh::operator*(
     Functional const& lhs, Functional const& rhs) {
-    return DISTMESH_FUNCTIONAL({
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return lhs(points) * rhs(points);
-    });
+    }), propagate(lhs, rhs, [](Eigen::ArrayXd const& lhsValue, Eigen::ArrayXXd const& lhsGradient,
+        Eigen::ArrayXd const& rhsValue, Eigen::ArrayXXd const& rhsGradient) {
+        return dual_t(lhsValue * rhsValue,
+            lhsGradient.colwise() * rhsValue + rhsGradient.colwise() * lhsValue);
+    }), createNode(tape::Operation::Multiply, lhs.node(), rhs.node())),
+    combine(lhs, rhs, [](Eigen::ArrayXf const& lhsValue, Eigen::ArrayXf const& rhsValue) {
+        return (lhsValue * rhsValue).eval();
+    }));
 }
 
 distmesh::Functional distmesh::operator*(
     Functional const& lhs, double const rhs) {
-    return DISTMESH_FUNCTIONAL({
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return lhs(points) * rhs;
-    });
+    }), propagate(lhs, [=](Eigen::ArrayXd const& value, Eigen::ArrayXXd const& gradient) {
+        return dual_t(value * rhs, gradient * rhs);
+    }), createNode(tape::Operation::Multiply, lhs.node(), createConstant(rhs))),
+    combine(lhs, [=](Eigen::ArrayXf const& value) {
+        return (value * float(rhs)).eval();
+    }));
 }
 
 distmesh::Functional distmesh::operator*(
     double const lhs, Functional const& rhs) {
-    return DISTMESH_FUNCTIONAL({
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return lhs * rhs(points);
-    });
+    }), propagate(rhs, [=](Eigen::ArrayXd const& value, Eigen::ArrayXXd const& gradient) {
+        return dual_t(lhs * value, lhs * gradient);
+    }), createNode(tape::Operation::Multiply, createConstant(lhs), rhs.node())),
+    combine(rhs, [=](Eigen::ArrayXf const& value) {
+        return (float(lhs) * value).eval();
+    }));
 }
 
 distmesh::Functional distmesh::operator/(
     Functional const& lhs, Functional const& rhs) {
-    return DISTMESH_FUNCTIONAL({
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return lhs(points) / rhs(points);
-    });
+    }), propagate(lhs, rhs, [](Eigen::ArrayXd const& lhsValue, Eigen::ArrayXXd const& lhsGradient,
+        Eigen::ArrayXd const& rhsValue, Eigen::ArrayXXd const& rhsGradient) {
+        return dual_t(lhsValue / rhsValue,
+            (lhsGradient.colwise() * rhsValue - rhsGradient.colwise() * lhsValue).colwise() /
+            rhsValue.square());
+    }), createNode(tape::Operation::Divide, lhs.node(), rhs.node())),
+    combine(lhs, rhs, [](Eigen::ArrayXf const& lhsValue, Eigen::ArrayXf const& rhsValue) {
+        return (lhsValue / rhsValue).eval();
+    }));
 }
 
 distmesh::Functional distmesh::operator/(
     Functional const& lhs, double const rhs) {
-    return DISTMESH_FUNCTIONAL({
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return lhs(points) / rhs;
-    });
+    }), propagate(lhs, [=](Eigen::ArrayXd const& value, Eigen::ArrayXXd const& gradient) {
+        return dual_t(value / rhs, gradient / rhs);
+    }), createNode(tape::Operation::Divide, lhs.node(), createConstant(rhs))),
+    combine(lhs, [=](Eigen::ArrayXf const& value) {
+        return (value / float(rhs)).eval();
+    }));
 }
 
 distmesh::Functional distmesh::operator/(
     double const lhs, Functional const& rhs) {
-    return DISTMESH_FUNCTIONAL({
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return lhs / rhs(points);
-    });
+    }), propagate(rhs, [=](Eigen::ArrayXd const& value, Eigen::ArrayXXd const& gradient) {
+        return dual_t(lhs / value,
+            gradient.colwise() * (-lhs / value.square()));
+    }), createNode(tape::Operation::Divide, createConstant(lhs), rhs.node())),
+    combine(rhs, [=](Eigen::ArrayXf const& value) {
+        return (float(lhs) / value).eval();
+    }));
 }
 
 distmesh::Functional distmesh::Functional::min(
     Functional const& rhs) const {
     auto const func = this->function();
-    return DISTMESH_FUNCTIONAL({
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return func(points).min(rhs(points));
-    });
+    }), propagate(*this, rhs, [](Eigen::ArrayXd const& lhsValue, Eigen::ArrayXXd const& lhsGradient,
+        Eigen::ArrayXd const& rhsValue, Eigen::ArrayXXd const& rhsGradient) {
+        return dual_t(lhsValue.min(rhsValue), (lhsValue <= rhsValue)
+            .replicate(1, lhsGradient.cols()).select(lhsGradient, rhsGradient));
+    }), createNode(tape::Operation::Minimum, this->node(), rhs.node())),
+    combine(*this, rhs, [](Eigen::ArrayXf const& lhsValue, Eigen::ArrayXf const& rhsValue) {
+        return (lhsValue.min(rhsValue)).eval();
+    }));
 }
 
 distmesh::Functional distmesh::Functional::max(
     Functional const& rhs) const {
     auto const func = this->function();
-    return DISTMESH_FUNCTIONAL({
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return func(points).max(rhs(points));
-    });
+    }), propagate(*this, rhs, [](Eigen::ArrayXd const& lhsValue, Eigen::ArrayXXd const& lhsGradient,
+        Eigen::ArrayXd const& rhsValue, Eigen::ArrayXXd const& rhsGradient) {
+        return dual_t(lhsValue.max(rhsValue), (lhsValue >= rhsValue)
+            .replicate(1, lhsGradient.cols()).select(lhsGradient, rhsGradient));
+    }), createNode(tape::Operation::Maximum, this->node(), rhs.node())),
+    combine(*this, rhs, [](Eigen::ArrayXf const& lhsValue, Eigen::ArrayXf const& rhsValue) {
+        return (lhsValue.max(rhsValue)).eval();
+    }));
 }
 
 distmesh::Functional distmesh::Functional::abs() const {
     auto const func = this->function();
-    return DISTMESH_FUNCTIONAL({
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return func(points).abs();
-    });
+    }), propagate(*this, [](Eigen::ArrayXd const& value, Eigen::ArrayXXd const& gradient) {
+        return dual_t(value.abs(), gradient.colwise() * value.sign());
+    }), createNode(tape::Operation::Abs, this->node())),
+    combine(*this, [](Eigen::ArrayXf const& value) {
+        return (value.abs()).eval();
+    }));
 }
 
 // geometric transform
-distmesh::Functional distmesh::Functional::shift(Eigen::Ref<Eigen::ArrayXd const> const offset) const {
+distmesh::Functional distmesh::Functional::shift(Eigen::Ref<Eigen::ArrayXd const> const _offset) const {
+    // copy offset, which has to outlive the reference
+    Eigen::ArrayXd const offset = _offset;
+
+    Eigen::ArrayXf const singleOffset = offset.cast<float>();
+
     auto const func = this->function();
-    return DISTMESH_FUNCTIONAL({
+    auto const gradient = this->gradient();
+    return withSingle(Functional(DISTMESH_FUNCTION({
         return func(points.rowwise() - offset.transpose());
-    });
+    }), this->hasGradient() ? [=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> dual_t {
+        return gradient(points.rowwise() - offset.transpose());
+    } : gradient_t(), createNode(tape::Operation::Shift, this->node(), nullptr,
+        std::vector<double>(offset.data(), offset.data() + offset.size()))),
+    transform(*this, [=](Eigen::Ref<Eigen::ArrayXXf const> const points) {
+        return (points.rowwise() - singleOffset.transpose()).eval();
+    }));
 }
 
 distmesh::Functional distmesh::Functional::rotate2D(double const angle) const {
+    float const cos = std::cos(angle), sin = std::sin(angle);
+
     auto const func = this->function();
-    return DISTMESH_FUNCTIONAL({
-        Eigen::ArrayXXd transformedPoints(points.rows(), points.cols());
+    auto const gradient = this->gradient();
+    return withSingle(Functional(DISTMESH_FUNCTION({
+        Eigen::ArrayXXd transformedPoints = points;
         transformedPoints.col(0) = points.col(0) * std::cos(angle) + points.col(1) * std::sin(angle);
         transformedPoints.col(1) = -points.col(0) * std::sin(angle) + points.col(1) * std::cos(angle);
 
         return func(transformedPoints);
-    });
-}
+    }), this->hasGradient() ? [=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> dual_t {
+        Eigen::ArrayXXd transformedPoints = points;
+        transformedPoints.col(0) = points.col(0) * std::cos(angle) + points.col(1) * std::sin(angle);
+        transformedPoints.col(1) = -points.col(0) * std::sin(angle) + points.col(1) * std::cos(angle);
+
+        // rotate gradient back to original coordinate system
+        auto dual = gradient(transformedPoints);
+        Eigen::ArrayXd const gradientX = std::get<1>(dual).col(0);
+        std::get<1>(dual).col(0) = gradientX * std::cos(angle) - std::get<1>(dual).col(1) * std::sin(angle);
+        std::get<1>(dual).col(1) = gradientX * std::sin(angle) + std::get<1>(dual).col(1) * std::cos(angle);
 
+        return dual;
+    } : gradient_t(), createNode(tape::Operation::Rotate2D, this->node(), nullptr,
+        std::vector<double>(1, angle))),
+    transform(*this, [=](Eigen::Ref<Eigen::ArrayXXf const> const points) {
+        Eigen::ArrayXXf transformedPoints = points;
+        transformedPoints.col(0) = points.col(0) * cos + points.col(1) * sin;
+        transformedPoints.col(1) = -points.col(0) * sin + points.col(1) * cos;
+        return transformedPoints;
+    }));
+}
@@ -0,0 +1,219 @@
+// --------------------------------------------------------------------
+// This file is part of libDistMesh.
+//
+// libDistMesh is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// libDistMesh is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libDistMesh. If not, see <http://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2015 Patrik Gebhardt
+// Contact: patrik.gebhardt@rub.de
+// --------------------------------------------------------------------
+
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <exception>
+
+#include "distmesh/distmesh.h"
+#include "distmesh/parallel.h"
+
+namespace {
+    // persistent pool of threads, which are created once and execute the workers
+    // of a single forEach call at a time together with the calling thread
+    class Pool {
+    public:
+        typedef std::function<void(unsigned const thread)> worker_t;
+
+        static Pool& instance() {
+            static Pool pool;
+            return pool;
+        }
+
+        ~Pool() {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                this->stop_ = true;
+            }
+            this->start_.notify_all();
+            for (auto& thread : this->threads_) {
+                thread.join();
+            }
+        }
+
+        // execute worker for all threads in range [0, threads), the calling thread
+        // works as the first thread, returns false without executing any worker,
+        // when the pool is already used by another forEach call
+        bool run(unsigned const threads, worker_t const& worker) {
+            std::unique_lock<std::mutex> use(this->use_, std::try_to_lock);
+            if (!use.owns_lock() || insideWorker()) {
+                return false;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                while (this->threads_.size() + 1 < threads) {
+                    this->threads_.push_back(std::thread(&Pool::loop, this,
+                        this->threads_.size() + 1));
+                }
+                this->worker_ = &worker;
+                this->workers_ = threads;
+                this->pending_ = threads - 1;
+                this->generation_++;
+            }
+            this->start_.notify_all();
+
+            insideWorker() = true;
+            worker(0);
+            insideWorker() = false;
+
+            std::unique_lock<std::mutex> lock(this->mutex_);
+            this->finish_.wait(lock, [this] { return this->pending_ == 0; });
+            this->worker_ = nullptr;
+
+            return true;
+        }
+
+    private:
+        Pool() : worker_(nullptr), workers_(0), pending_(0), generation_(0), stop_(false) {}
+
+        // marks threads executing a worker to run nested calls serially
+        static bool& insideWorker() {
+            static thread_local bool inside = false;
+            return inside;
+        }
+
+        // wait for the next forEach call and execute the worker, when the
+        // thread is needed by the call
+        void loop(unsigned const thread) {
+            insideWorker() = true;
+            unsigned long generation = 0;
+            while (true) {
+                std::unique_lock<std::mutex> lock(this->mutex_);
+                this->start_.wait(lock, [&] {
+                    return this->stop_ || (this->generation_ != generation);
+                });
+                if (this->stop_) {
+                    return;
+                }
+                generation = this->generation_;
+                if (thread >= this->workers_) {
+                    continue;
+                }
+                worker_t const& worker = *this->worker_;
+                lock.unlock();
+
+                worker(thread);
+
+                lock.lock();
+                if (--this->pending_ == 0) {
+                    this->finish_.notify_one();
+                }
+            }
+        }
+
+        std::mutex use_;
+        std::mutex mutex_;
+        std::condition_variable start_;
+        std::condition_variable finish_;
+        std::vector<std::thread> threads_;
+        worker_t const* worker_;
+        unsigned workers_;
+        unsigned pending_;
+        unsigned long generation_;
+        bool stop_;
+    };
+}
+
+// number of concurrent threads supported by the hardware
+unsigned distmesh::parallel::hardwareThreads() {
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+// execute task for all indices on the work stealing pool of threads
+void distmesh::parallel::forEach(unsigned const count, unsigned const _threads,
+    task_t const& task) {
+    unsigned const threads = std::min(_threads == 0 ? hardwareThreads() : _threads,
+        std::max(count, 1u));
+
+    // run serially without any synchronisation overhead
+    if (threads == 1) {
+        for (unsigned index = 0; index < count; ++index) {
+            task(index, 0);
+        }
+        return;
+    }
+
+    // each thread gets its own queue of contiguous indices
+    struct Queue {
+        std::mutex mutex;
+        std::deque<unsigned> indices;
+    };
+    std::vector<Queue> queues(threads);
+    for (unsigned index = 0; index < count; ++index) {
+        queues[(unsigned long)index * threads / count].indices.push_back(index);
+    }
+
+    // first exception thrown by any task
+    std::mutex exceptionMutex;
+    std::exception_ptr exception;
+
+    auto const worker = [&](unsigned const thread) {
+        while (true) {
+            // take next index from own queue, or steal one from the end
+            // of another queue, when own queue is empty
+            bool found = false;
+            unsigned index = 0;
+            for (unsigned victim = 0; (victim < threads) && !found; ++victim) {
+                Queue& queue = queues[(thread + victim) % threads];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+
+                if (!queue.indices.empty()) {
+                    if (victim == 0) {
+                        index = queue.indices.front();
+                        queue.indices.pop_front();
+                    }
+                    else {
+                        index = queue.indices.back();
+                        queue.indices.pop_back();
+                    }
+                    found = true;
+                }
+            }
+            if (!found) {
+                break;
+            }
+
+            try {
+                task(index, thread);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(exceptionMutex);
+                if (!exception) {
+                    exception = std::current_exception();
+                }
+            }
+        }
+    };
+
+    // nested or concurrent calls, which cannot use the pool, are run serially
+    // by the calling thread stealing all indices of the other queues
+    if (!Pool::instance().run(threads, worker)) {
+        worker(0);
+    }
+
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
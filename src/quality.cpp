@@ -0,0 +1,151 @@
+// --------------------------------------------------------------------
+// This file is part of libDistMesh.
+//
+// libDistMesh is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// libDistMesh is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libDistMesh. If not, see <http://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2015 Patrik Gebhardt
+// Contact: patrik.gebhardt@rub.de
+// --------------------------------------------------------------------
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "distmesh/distmesh.h"
+#include "distmesh/quality.h"
+
+// coordinates of the given node of all elements
+static Eigen::ArrayXXd nodes(Eigen::Ref<Eigen::ArrayXXd const> const points,
+    Eigen::Ref<Eigen::ArrayXXi const> const triangulation, int const node) {
+    return distmesh::utils::selectIndexedArrayElements<double>(points, triangulation.col(node));
+}
+
+// row wise cross product of three dimensional vectors
+static Eigen::ArrayXXd cross(Eigen::Ref<Eigen::ArrayXXd const> const a,
+    Eigen::Ref<Eigen::ArrayXXd const> const b) {
+    Eigen::ArrayXXd result(a.rows(), 3);
+    result.col(0) = a.col(1) * b.col(2) - a.col(2) * b.col(1);
+    result.col(1) = a.col(2) * b.col(0) - a.col(0) * b.col(2);
+    result.col(2) = a.col(0) * b.col(1) - a.col(1) * b.col(0);
+
+    return result;
+}
+
+Eigen::ArrayXd distmesh::quality::radiusRatio(Eigen::Ref<Eigen::ArrayXXd const> const points,
+    Eigen::Ref<Eigen::ArrayXXi const> const triangulation) {
+    if (triangulation.cols() == 3) {
+        // edge lengths opposite to each node
+        auto const a = (nodes(points, triangulation, 1) - nodes(points, triangulation, 2))
+            .square().rowwise().sum().sqrt().eval();
+        auto const b = (nodes(points, triangulation, 0) - nodes(points, triangulation, 2))
+            .square().rowwise().sum().sqrt().eval();
+        auto const c = (nodes(points, triangulation, 0) - nodes(points, triangulation, 1))
+            .square().rowwise().sum().sqrt().eval();
+
+        return (b + c - a) * (c + a - b) * (a + b - c) / (a * b * c);
+    }
+
+    if ((triangulation.cols() != 4) || (points.cols() != 3)) {
+        throw std::invalid_argument(
+            "quality::radiusRatio: only triangles and tetrahedra in three dimensions are supported");
+    }
+
+    // edge vectors starting at first node of each tetrahedron
+    auto const origin = nodes(points, triangulation, 0);
+    auto const u = (nodes(points, triangulation, 1) - origin).eval();
+    auto const v = (nodes(points, triangulation, 2) - origin).eval();
+    auto const w = (nodes(points, triangulation, 3) - origin).eval();
+
+    // six times the signed volume and the circumcenter relative to the origin
+    auto const vw = cross(v, w), wu = cross(w, u), uv = cross(u, v);
+    auto const volume = (u * vw).rowwise().sum().eval();
+    auto const center = ((vw.colwise() * u.square().rowwise().sum() +
+        wu.colwise() * v.square().rowwise().sum() +
+        uv.colwise() * w.square().rowwise().sum()).colwise() / (2.0 * volume)).eval();
+
+    // the inradius is three times the volume divided by the surface area,
+    // using twice the area of each face
+    auto const area = (vw.square().rowwise().sum().sqrt() + wu.square().rowwise().sum().sqrt() +
+        uv.square().rowwise().sum().sqrt() +
+        cross(v - u, w - u).square().rowwise().sum().sqrt()).eval();
+
+    return 3.0 * (volume.abs() / area) / center.square().rowwise().sum().sqrt();
+}
+
+Eigen::ArrayXXd distmesh::quality::angles(Eigen::Ref<Eigen::ArrayXXd const> const points,
+    Eigen::Ref<Eigen::ArrayXXi const> const triangulation) {
+    // squared edge lengths opposite to each node
+    Eigen::ArrayXXd lengths(triangulation.rows(), 3);
+    for (int node = 0; node < 3; ++node) {
+        lengths.col(node) = (nodes(points, triangulation, (node + 1) % 3) -
+            nodes(points, triangulation, (node + 2) % 3)).square().rowwise().sum();
+    }
+
+    // law of cosines
+    Eigen::ArrayXXd result(triangulation.rows(), 3);
+    for (int node = 0; node < 3; ++node) {
+        auto const& b = lengths.col((node + 1) % 3);
+        auto const& c = lengths.col((node + 2) % 3);
+
+        result.col(node) = ((b + c - lengths.col(node)) / (2.0 * (b * c).sqrt()))
+            .max(-1.0).min(1.0).acos();
+    }
+
+    return result;
+}
+
+Eigen::ArrayXXd distmesh::quality::dihedralAngles(Eigen::Ref<Eigen::ArrayXXd const> const points,
+    Eigen::Ref<Eigen::ArrayXXi const> const triangulation) {
+    auto const edges = utils::nOverK(4, 2);
+
+    Eigen::ArrayXXd result(triangulation.rows(), edges.rows());
+    for (int edge = 0; edge < edges.rows(); ++edge) {
+        // the two nodes not belonging to the edge
+        int others[2], count = 0;
+        for (int node = 0; node < 4; ++node) {
+            if ((node != edges(edge, 0)) && (node != edges(edge, 1))) {
+                others[count++] = node;
+            }
+        }
+
+        // angle between the normals of both faces adjacent to the edge
+        auto const origin = nodes(points, triangulation, edges(edge, 0));
+        auto const direction = (nodes(points, triangulation, edges(edge, 1)) - origin).eval();
+        auto const first = cross(direction, nodes(points, triangulation, others[0]) - origin);
+        auto const second = cross(direction, nodes(points, triangulation, others[1]) - origin);
+
+        auto const sine = cross(first, second).square().rowwise().sum().sqrt().eval();
+        auto const cosine = (first * second).rowwise().sum().eval();
+        for (int element = 0; element < triangulation.rows(); ++element) {
+            result(element, edge) = std::atan2(sine(element), cosine(element));
+        }
+    }
+
+    return result;
+}
+
+double distmesh::quality::percentile(Eigen::Ref<Eigen::ArrayXd const> const values,
+    double const fraction) {
+    if (values.rows() == 0) {
+        return 0.0;
+    }
+
+    std::vector<double> sorted(values.data(), values.data() + values.rows());
+    auto const nth = sorted.begin() + static_cast<std::ptrdiff_t>(
+        std::min(std::max(fraction, 0.0), 1.0) * (sorted.size() - 1));
+    std::nth_element(sorted.begin(), nth, sorted.end());
+
+    return *nth;
+}
@@ -0,0 +1,296 @@
+// --------------------------------------------------------------------
+// This file is part of libDistMesh.
+//
+// libDistMesh is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// libDistMesh is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libDistMesh. If not, see <http://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2015 Patrik Gebhardt
+// Contact: patrik.gebhardt@rub.de
+// --------------------------------------------------------------------
+
+#include <map>
+#include <tuple>
+#include <cmath>
+#include <algorithm>
+
+#include "distmesh/distmesh.h"
+
+namespace {
+    // value of the linear program before register allocation, each value is
+    // computed once and either is a points array or an array of function values
+    struct Value {
+        distmesh::tape::Operation operation;
+        bool points;
+        int lhs;
+        int rhs;
+        std::vector<double> parameters;
+        distmesh::Functional::function_t function;
+    };
+
+    // records symbolic description as linear program, identical subexpressions
+    // are recognized by their operation, parameters and operands
+    class Recorder {
+    public:
+        // value 0 refers to the input points
+        Recorder() : values(1, Value{ distmesh::tape::Operation::Function, true, -1, -1,
+            std::vector<double>(), nullptr }) {}
+
+        int record(std::shared_ptr<distmesh::tape::Node const> const& node, int const points) {
+            using distmesh::tape::Operation;
+
+            // each node has to be recorded only once for each points value
+            auto const memo = this->recorded.find(std::make_pair(node.get(), points));
+            if (memo != this->recorded.end()) {
+                return memo->second;
+            }
+
+            int result = -1;
+            switch (node->operation) {
+            case Operation::Constant:
+                result = this->emit(node->operation, false, -1, -1, node->parameters);
+                break;
+
+            case Operation::Function:
+                // functions without name are only identical to themselves
+                result = this->emit(node->operation, false, points, -1, node->parameters,
+                    node->name, node->function, node->name.empty() ? node.get() : nullptr);
+                break;
+
+            case Operation::Negate:
+            case Operation::Abs:
+                result = this->emit(node->operation, false,
+                    this->record(node->operands[0], points), -1);
+                break;
+
+            case Operation::Shift:
+            case Operation::Rotate2D:
+                result = this->record(node->operands[0], this->emit(node->operation, true,
+                    points, -1, node->parameters));
+                break;
+
+            default:
+                result = this->emit(node->operation, false,
+                    this->record(node->operands[0], points),
+                    this->record(node->operands[1], points));
+                break;
+            }
+
+            this->recorded[std::make_pair(node.get(), points)] = result;
+            return result;
+        }
+
+        std::vector<Value> values;
+
+    private:
+        typedef std::tuple<distmesh::tape::Operation, int, int, std::vector<double>,
+            std::string, void const*> key_t;
+
+        int emit(distmesh::tape::Operation const operation, bool const points,
+            int const lhs, int const rhs,
+            std::vector<double> const& parameters=std::vector<double>(),
+            std::string const& name="",
+            distmesh::Functional::function_t const& function=nullptr,
+            void const* const identity=nullptr) {
+            // reuse already computed value
+            key_t const key = std::make_tuple(operation, lhs, rhs, parameters, name, identity);
+            auto const existing = this->keys.find(key);
+            if (existing != this->keys.end()) {
+                return existing->second;
+            }
+
+            this->values.push_back(Value{ operation, points, lhs, rhs, parameters, function });
+            this->keys[key] = this->values.size() - 1;
+            return this->values.size() - 1;
+        }
+
+        std::map<key_t, int> keys;
+        std::map<std::pair<void const*, int>, int> recorded;
+    };
+}
+
+distmesh::tape::Tape::Tape(Functional const& functional, unsigned const blockSize)
+    : valueRegisters_(0), pointsRegisters_(1), blockSize_(std::max(blockSize, 1u)), result_(-1) {
+    // functionals without symbolic description are treated as opaque function
+    auto const node = functional.node() != nullptr ? functional.node() :
+        std::make_shared<Node const>(Operation::Function, std::vector<std::shared_ptr<Node const>>(),
+            std::vector<double>(), "", functional.function());
+
+    // record linear program and find last instruction using each value
+    Recorder recorder;
+    int const result = recorder.record(node, 0);
+    auto const& values = recorder.values;
+
+    std::vector<size_t> lastUse(values.size(), 0);
+    for (size_t value = 1; value < values.size(); ++value) {
+        if (values[value].lhs >= 0) {
+            lastUse[values[value].lhs] = value;
+        }
+        if (values[value].rhs >= 0) {
+            lastUse[values[value].rhs] = value;
+        }
+    }
+    lastUse[result] = values.size();
+
+    // assign registers to values, registers of values not used anymore are
+    // released before allocating the result, since all operations work
+    // coefficient wise, the input points always occupy points register 0
+    std::vector<int> registers(values.size(), 0);
+    std::vector<int> freeValueRegisters, freePointsRegisters;
+    for (size_t value = 1; value < values.size(); ++value) {
+        int const lhs = values[value].lhs, rhs = values[value].rhs;
+        for (auto const operand : { lhs, rhs != lhs ? rhs : -1 }) {
+            if ((operand > 0) && (lastUse[operand] == value)) {
+                (values[operand].points ? freePointsRegisters : freeValueRegisters)
+                    .push_back(registers[operand]);
+            }
+        }
+
+        auto& freeRegisters = values[value].points ? freePointsRegisters : freeValueRegisters;
+        if (!freeRegisters.empty()) {
+            registers[value] = freeRegisters.back();
+            freeRegisters.pop_back();
+        }
+        else {
+            registers[value] = values[value].points ? this->pointsRegisters_++ :
+                this->valueRegisters_++;
+        }
+
+        Instruction instruction;
+        instruction.operation = values[value].operation;
+        instruction.result = registers[value];
+        instruction.lhs = lhs >= 0 ? registers[lhs] : -1;
+        instruction.rhs = rhs >= 0 ? registers[rhs] : -1;
+        instruction.parameters = Eigen::Map<Eigen::ArrayXd const>(
+            values[value].parameters.data(), values[value].parameters.size());
+        instruction.function = values[value].function;
+        this->instructions_.push_back(instruction);
+    }
+    this->result_ = registers[result];
+}
+
+Eigen::ArrayXd distmesh::tape::Tape::operator()(
+    Eigen::Ref<Eigen::ArrayXXd const> const points) const {
+    // scratch registers are allocated once and reused for all blocks
+    std::vector<Eigen::ArrayXd> valueRegisters(this->valueRegisters_,
+        Eigen::ArrayXd(std::min<Eigen::Index>(this->blockSize_, points.rows())));
+    std::vector<Eigen::ArrayXXd> pointsRegisters(this->pointsRegisters_,
+        Eigen::ArrayXXd(std::min<Eigen::Index>(this->blockSize_, points.rows()), points.cols()));
+
+    Eigen::ArrayXd result(points.rows());
+    for (Eigen::Index start = 0; start < points.rows(); start += this->blockSize_) {
+        Eigen::Index const count = std::min<Eigen::Index>(this->blockSize_, points.rows() - start);
+        auto const pointsBlock = [&](int const index) -> Eigen::Ref<Eigen::ArrayXXd const> {
+            if (index == 0) {
+                return points.middleRows(start, count);
+            }
+            return pointsRegisters[index].topRows(count);
+        };
+
+        for (auto const& instruction : this->instructions_) {
+            switch (instruction.operation) {
+            case Operation::Function:
+                valueRegisters[instruction.result].head(count) =
+                    instruction.function(pointsBlock(instruction.lhs));
+                break;
+
+            case Operation::Constant:
+                valueRegisters[instruction.result].head(count).setConstant(instruction.parameters(0));
+                break;
+
+            case Operation::Negate:
+                valueRegisters[instruction.result].head(count) =
+                    -valueRegisters[instruction.lhs].head(count);
+                break;
+
+            case Operation::Abs:
+                valueRegisters[instruction.result].head(count) =
+                    valueRegisters[instruction.lhs].head(count).abs();
+                break;
+
+            case Operation::Add:
+                valueRegisters[instruction.result].head(count) =
+                    valueRegisters[instruction.lhs].head(count) +
+                    valueRegisters[instruction.rhs].head(count);
+                break;
+
+            case Operation::Subtract:
+                valueRegisters[instruction.result].head(count) =
+                    valueRegisters[instruction.lhs].head(count) -
+                    valueRegisters[instruction.rhs].head(count);
+                break;
+
+            case Operation::Multiply:
+                valueRegisters[instruction.result].head(count) =
+                    valueRegisters[instruction.lhs].head(count) *
+                    valueRegisters[instruction.rhs].head(count);
+                break;
+
+            case Operation::Divide:
+                valueRegisters[instruction.result].head(count) =
+                    valueRegisters[instruction.lhs].head(count) /
+                    valueRegisters[instruction.rhs].head(count);
+                break;
+
+            case Operation::Minimum:
+                valueRegisters[instruction.result].head(count) =
+                    valueRegisters[instruction.lhs].head(count).min(
+                    valueRegisters[instruction.rhs].head(count));
+                break;
+
+            case Operation::Maximum:
+                valueRegisters[instruction.result].head(count) =
+                    valueRegisters[instruction.lhs].head(count).max(
+                    valueRegisters[instruction.rhs].head(count));
+                break;
+
+            case Operation::Shift:
+                pointsRegisters[instruction.result].topRows(count) =
+                    pointsBlock(instruction.lhs).rowwise() - instruction.parameters.transpose();
+                break;
+
+            case Operation::Rotate2D: {
+                // copy first column, since result might share register with operand
+                Eigen::ArrayXd const x = pointsBlock(instruction.lhs).col(0);
+                double const cos = std::cos(instruction.parameters(0));
+                double const sin = std::sin(instruction.parameters(0));
+
+                pointsRegisters[instruction.result].topRows(count) = pointsBlock(instruction.lhs);
+                pointsRegisters[instruction.result].col(0).head(count) =
+                    x * cos + pointsBlock(instruction.lhs).col(1) * sin;
+                pointsRegisters[instruction.result].col(1).head(count) =
+                    -x * sin + pointsBlock(instruction.lhs).col(1) * cos;
+                break;
+            }
+            }
+        }
+
+        result.segment(start, count) = valueRegisters[this->result_].head(count);
+    }
+
+    return result;
+}
+
+distmesh::Functional distmesh::tape::compile(Functional const& functional,
+    unsigned const blockSize) {
+    auto const tape = std::make_shared<Tape const>(functional, blockSize);
+
+    // keep gradient and symbolic description to allow further composition
+    // of the functional, and the single precision evaluation of the source,
+    // since the tape only evaluates double precision
+    Functional result([=](Eigen::Ref<Eigen::ArrayXXd const> const points) -> Eigen::ArrayXd {
+        return (*tape)(points);
+    }, functional.gradient(), functional.node());
+    result.single() = functional.single();
+
+    return result;
+}
@@ -19,22 +19,30 @@
 // --------------------------------------------------------------------
 
 #include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
 
-// qhull library used to calculate delaunay triangulation
+// reentrant qhull library used to calculate delaunay triangulation
 extern "C" {
-    #define qh_QHimport
-    #include <qhull/qhull_a.h>
+    #include <libqhull_r/qhull_ra.h>
 }
 
 #include "distmesh/distmesh.h"
 #include "distmesh/triangulation.h"
 
-Eigen::ArrayXXi distmesh::triangulation::delaunay(
+distmesh::triangulation::Triangulator::Triangulator()
+    : context_(new qhT) {
+}
+
+distmesh::triangulation::Triangulator::~Triangulator() {
+    delete this->context_;
+}
+
+Eigen::ArrayXXi distmesh::triangulation::Triangulator::delaunay(
     Eigen::Ref<Eigen::ArrayXXd const> const points) {
-    // reset qhull
-    if (qh_qh) {
-        qh_save_qhull();
-    }
+    // all qhull macros refer to the context by the name qh
+    qhT* const qh = this->context_;
 
     // convert points array to row major format
     Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic,
@@ -42,16 +50,20 @@ Eigen::ArrayXXi distmesh::triangulation::delaunay(
 
     // calculate delaunay triangulation
     std::string flags = "qhull d Qt Qbb Qc Qz";
-    qh_new_qhull(points.cols(), points.rows(), pointsRowMajor.data(), False,
-        (char*)flags.c_str(), nullptr, stderr);
-    qh_triangulate();
+    qh_zero(qh, stderr);
+    int const exitCode = qh_new_qhull(qh, points.cols(), points.rows(), pointsRowMajor.data(),
+        False, (char*)flags.c_str(), nullptr, stderr);
 
     // count all upper delaunay facets
     unsigned facetCount = 0;
     facetT* facet;
-    FORALLfacets {
-        if (!facet->upperdelaunay) {
-            facetCount++;
+    if (exitCode == 0) {
+        qh_triangulate(qh);
+
+        FORALLfacets {
+            if (!facet->upperdelaunay) {
+                facetCount++;
+            }
         }
     }
 
@@ -61,17 +73,257 @@ Eigen::ArrayXXi distmesh::triangulation::delaunay(
     unsigned vertexId = 0;
     vertexT* vertex, **vertexp;
 
-    FORALLfacets {
-        vertexId = 0;
-        if (!facet->upperdelaunay) {
-            qh_setsize(facet->vertices);
-            FOREACHvertex_(facet->vertices) {
-                triangulation(facetId, vertexId) = qh_pointid(vertex->point);
-                vertexId++;
+    if (exitCode == 0) {
+        FORALLfacets {
+            vertexId = 0;
+            if (!facet->upperdelaunay) {
+                qh_setsize(qh, facet->vertices);
+                FOREACHvertex_(facet->vertices) {
+                    triangulation(facetId, vertexId) = qh_pointid(qh, vertex->point);
+                    vertexId++;
+                }
+                facetId++;
             }
-            facetId++;
         }
     }
 
+    // release all memory allocated by qhull
+    int currentLong = 0, totalLong = 0;
+    qh_freeqhull(qh, !qh_ALL);
+    qh_memfreeshort(qh, &currentLong, &totalLong);
+
     return triangulation;
 }
+
+Eigen::ArrayXXi distmesh::triangulation::delaunay(
+    Eigen::Ref<Eigen::ArrayXXd const> const points) {
+    return Triangulator().delaunay(points);
+}
+
+// orientation of 2d triangle, positive for counterclockwise ordered nodes,
+// evaluated in double precision for all point types
+template <
+    class type
+>
+static inline double orientation(
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const& points,
+    int const a, int const b, int const c) {
+    return (double(points(b, 0)) - double(points(a, 0))) *
+        (double(points(c, 1)) - double(points(a, 1))) -
+        (double(points(b, 1)) - double(points(a, 1))) *
+        (double(points(c, 0)) - double(points(a, 0)));
+}
+
+// check whether node d lies inside of the circumcircle of the counterclockwise
+// ordered triangle a, b, c, with a relative tolerance to avoid flipping of
+// cocircular configurations back and forth
+template <
+    class type
+>
+static inline bool inCircumcircle(
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const& points,
+    int const a, int const b, int const c, int const d) {
+    double const adx = double(points(a, 0)) - double(points(d, 0));
+    double const ady = double(points(a, 1)) - double(points(d, 1));
+    double const bdx = double(points(b, 0)) - double(points(d, 0));
+    double const bdy = double(points(b, 1)) - double(points(d, 1));
+    double const cdx = double(points(c, 0)) - double(points(d, 0));
+    double const cdy = double(points(c, 1)) - double(points(d, 1));
+    double const ad = adx * adx + ady * ady;
+    double const bd = bdx * bdx + bdy * bdy;
+    double const cd = cdx * cdx + cdy * cdy;
+
+    double const determinant = ad * (bdx * cdy - cdx * bdy) +
+        bd * (cdx * ady - adx * cdy) + cd * (adx * bdy - bdx * ady);
+    double const magnitude = ad * std::abs(bdx * cdy - cdx * bdy) +
+        bd * std::abs(cdx * ady - adx * cdy) + cd * std::abs(adx * bdy - bdx * ady);
+
+    return determinant > 1e-12 * magnitude;
+}
+
+template <
+    class type
+>
+bool distmesh::triangulation::updateDelaunay(
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points,
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const previousPoints,
+    Eigen::Ref<Eigen::ArrayXXi> triangulation) {
+    // edge flips are only implemented for triangular meshes
+    if ((points.cols() != 2) || (triangulation.cols() != 3) ||
+        (previousPoints.rows() != points.rows())) {
+        return false;
+    }
+
+    // bring all triangles into counterclockwise order and reject the
+    // triangulation, if any triangle got inverted by the points movement
+    for (int triangle = 0; triangle < triangulation.rows(); ++triangle) {
+        int const a = triangulation(triangle, 0), b = triangulation(triangle, 1),
+            c = triangulation(triangle, 2);
+        double const previous = orientation<type>(previousPoints, a, b, c);
+        double const current = orientation<type>(points, a, b, c);
+
+        if ((previous == 0.0) || (previous * current <= 0.0)) {
+            return false;
+        }
+        else if (current < 0.0) {
+            std::swap(triangulation(triangle, 1), triangulation(triangle, 2));
+        }
+    }
+
+    // find neighbouring triangles, neighbours(triangle, node) contains the
+    // triangle opposite to the node or -1 at the boundary of the triangulation,
+    // by sorting all edges with their node indices packed in a single key
+    std::vector<std::pair<uint64_t, int>> edges(triangulation.rows() * 3);
+    for (int triangle = 0; triangle < triangulation.rows(); ++triangle)
+    for (int node = 0; node < 3; ++node) {
+        uint64_t const a = triangulation(triangle, (node + 1) % 3);
+        uint64_t const b = triangulation(triangle, (node + 2) % 3);
+        edges[triangle * 3 + node] = std::make_pair(
+            std::min(a, b) << 32 | std::max(a, b), triangle * 3 + node);
+    }
+    std::sort(edges.begin(), edges.end());
+
+    Eigen::ArrayXXi neighbours = Eigen::ArrayXXi::Constant(triangulation.rows(), 3, -1);
+    for (size_t edge = 1; edge < edges.size(); ++edge) {
+        if (edges[edge].first == edges[edge - 1].first) {
+            // edges shared by more than two triangles indicate overlapping elements
+            if ((edge > 1) && (edges[edge].first == edges[edge - 2].first)) {
+                return false;
+            }
+
+            int const first = edges[edge - 1].second, second = edges[edge].second;
+            neighbours(first / 3, first % 3) = second / 3;
+            neighbours(second / 3, second % 3) = first / 3;
+        }
+    }
+
+    // the triangulation covers the convex hull of all points, so the boundary
+    // of the triangulation has to stay convex, since edge flips cannot change it,
+    // boundary edges are oriented counterclockwise around the triangulation
+    std::vector<int> nextBoundaryNode(points.rows(), -1);
+    for (int triangle = 0; triangle < triangulation.rows(); ++triangle)
+    for (int node = 0; node < 3; ++node) {
+        if (neighbours(triangle, node) < 0) {
+            int const b = triangulation(triangle, (node + 1) % 3);
+            if (nextBoundaryNode[b] >= 0) {
+                return false;
+            }
+            nextBoundaryNode[b] = triangulation(triangle, (node + 2) % 3);
+        }
+    }
+    for (int b = 0; b < points.rows(); ++b) {
+        int const c = nextBoundaryNode[b];
+        if ((c >= 0) && (nextBoundaryNode[c] >= 0) &&
+            (orientation<type>(points, b, c, nextBoundaryNode[c]) < 0.0)) {
+            return false;
+        }
+    }
+
+    // since almost all points are moved in each step, every interior edge is
+    // checked once and only illegal edges are marked for flipping
+    std::vector<std::pair<int, int>> stack;
+    for (int triangle = 0; triangle < triangulation.rows(); ++triangle)
+    for (int node = 0; node < 3; ++node) {
+        int const neighbour = neighbours(triangle, node);
+        if (neighbour <= triangle) {
+            continue;
+        }
+
+        int opposite = 0;
+        while (neighbours(neighbour, opposite) != triangle) {
+            opposite++;
+        }
+        if (inCircumcircle<type>(points, triangulation(triangle, node),
+            triangulation(triangle, (node + 1) % 3), triangulation(triangle, (node + 2) % 3),
+            triangulation(neighbour, opposite))) {
+            stack.push_back(std::make_pair(triangle, node));
+        }
+    }
+
+    // flip illegal edges, until delaunay property is restored, limit number
+    // of flips to guarantee termination for degenerated configurations
+    size_t flips = 0;
+    size_t const maxFlips = 32 * static_cast<size_t>(triangulation.rows());
+    while (!stack.empty()) {
+        int const triangle = stack.back().first;
+        int const node = stack.back().second;
+        stack.pop_back();
+
+        // check edge opposite to node with neighbour triangle
+        int const neighbour = neighbours(triangle, node);
+        if (neighbour < 0) {
+            continue;
+        }
+
+        int const a = triangulation(triangle, node);
+        int const b = triangulation(triangle, (node + 1) % 3);
+        int const c = triangulation(triangle, (node + 2) % 3);
+
+        int opposite = 0;
+        while (neighbours(neighbour, opposite) != triangle) {
+            opposite++;
+        }
+        int const d = triangulation(neighbour, opposite);
+
+        // flip edge b-c to a-d, if it is illegal and the quadrilateral is convex
+        if (!inCircumcircle<type>(points, a, b, c, d) ||
+            (orientation<type>(points, a, b, d) <= 0.0) ||
+            (orientation<type>(points, a, d, c) <= 0.0)) {
+            continue;
+        }
+        if (++flips > maxFlips) {
+            return false;
+        }
+
+        // neighbours of the quadrilateral a, b, d, c, the neighbour triangle
+        // is ordered as d, c, b due to its counterclockwise orientation
+        int const neighbourAB = neighbours(triangle, (node + 2) % 3);
+        int const neighbourCA = neighbours(triangle, (node + 1) % 3);
+        int const neighbourBD = neighbours(neighbour, (opposite + 1) % 3);
+        int const neighbourDC = neighbours(neighbour, (opposite + 2) % 3);
+
+        // replace triangles by a, b, d and a, d, c
+        triangulation.row(triangle) << a, b, d;
+        triangulation.row(neighbour) << a, d, c;
+        neighbours.row(triangle) << neighbourBD, neighbour, neighbourAB;
+        neighbours.row(neighbour) << neighbourDC, neighbourCA, triangle;
+
+        // update back references of outer neighbours, which changed their triangle
+        if (neighbourBD >= 0) {
+            for (int i = 0; i < 3; ++i) {
+                if (neighbours(neighbourBD, i) == neighbour) {
+                    neighbours(neighbourBD, i) = triangle;
+                }
+            }
+        }
+        if (neighbourCA >= 0) {
+            for (int i = 0; i < 3; ++i) {
+                if (neighbours(neighbourCA, i) == triangle) {
+                    neighbours(neighbourCA, i) = neighbour;
+                }
+            }
+        }
+
+        // outer edges of quadrilateral might have become illegal
+        stack.push_back(std::make_pair(triangle, 0));
+        stack.push_back(std::make_pair(triangle, 2));
+        stack.push_back(std::make_pair(neighbour, 0));
+        stack.push_back(std::make_pair(neighbour, 1));
+    }
+
+    return true;
+}
+
+template bool distmesh::triangulation::updateDelaunay<float>(
+    Eigen::Ref<Eigen::ArrayXXf const> const, Eigen::Ref<Eigen::ArrayXXf const> const,
+    Eigen::Ref<Eigen::ArrayXXi>);
+template bool distmesh::triangulation::updateDelaunay<double>(
+    Eigen::Ref<Eigen::ArrayXXd const> const, Eigen::Ref<Eigen::ArrayXXd const> const,
+    Eigen::Ref<Eigen::ArrayXXi>);
+
+bool distmesh::triangulation::updateDelaunay(
+    Eigen::Ref<Eigen::ArrayXXd const> const points,
+    Eigen::Ref<Eigen::ArrayXXd const> const previousPoints,
+    Eigen::Ref<Eigen::ArrayXXi> triangulation) {
+    return updateDelaunay<double>(points, previousPoints, triangulation);
+}
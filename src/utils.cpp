@@ -18,12 +18,16 @@
 // Contact: patrik.gebhardt@rub.de
 // --------------------------------------------------------------------
 
-#include <set>
-#include <array>
 #include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <array>
+#include <random>
+#include <type_traits>
 
 #include "distmesh/distmesh.h"
 #include "distmesh/constants.h"
+#include "distmesh/parallel.h"
 
 // easy creation of n-dimensional bounding box
 Eigen::ArrayXXd distmesh::utils::boundingBox(unsigned const dimension) {
@@ -33,11 +37,81 @@ Eigen::ArrayXXd distmesh::utils::boundingBox(unsigned const dimension) {
     return box;
 }
 
+// hash of the cell of a uniform grid
+static inline uint64_t cellHash(Eigen::Ref<Eigen::ArrayXi const> const cell) {
+    uint64_t hash = 0;
+    for (int dim = 0; dim < cell.rows(); ++dim) {
+        hash = (hash ^ (uint32_t)cell(dim)) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// mark all points lying within the tolerance to any of the reference points
+Eigen::Array<bool, Eigen::Dynamic, 1> distmesh::utils::findNearbyPoints(
+    Eigen::Ref<Eigen::ArrayXXd const> const points,
+    Eigen::Ref<Eigen::ArrayXXd const> const referencePoints,
+    double const cellSize, double const tolerance, unsigned const threads) {
+    Eigen::Array<bool, Eigen::Dynamic, 1> nearby =
+        Eigen::Array<bool, Eigen::Dynamic, 1>::Constant(points.rows(), false);
+    if (referencePoints.rows() == 0) {
+        return nearby;
+    }
+
+    // sort reference points by the hash of their cell in a uniform grid
+    std::vector<std::pair<uint64_t, int>> grid(referencePoints.rows());
+    for (int point = 0; point < referencePoints.rows(); ++point) {
+        Eigen::ArrayXi const cell = (referencePoints.row(point) / cellSize).floor().cast<int>().transpose();
+        grid[point] = std::make_pair(cellHash(cell), point);
+    }
+    std::sort(grid.begin(), grid.end());
+
+    // compare each point only with the reference points in all cells
+    // touched by the tolerance around it
+    int const blockCount = threads == 1 ? 1 : 8 * (threads == 0 ? parallel::hardwareThreads() : threads);
+    int const blockSize = (points.rows() + blockCount - 1) / blockCount;
+    parallel::forEach(blockCount, threads, [&](unsigned const block, unsigned const) {
+        int const end = std::min((int)(block + 1) * blockSize, (int)points.rows());
+        for (int point = block * blockSize; point < end; ++point) {
+            Eigen::ArrayXi const first = ((points.row(point) - tolerance) / cellSize).floor().cast<int>().transpose();
+            Eigen::ArrayXi const last = ((points.row(point) + tolerance) / cellSize).floor().cast<int>().transpose();
+            Eigen::ArrayXi cell = first;
+
+            while (!nearby(point)) {
+                auto range = std::equal_range(grid.begin(), grid.end(),
+                    std::make_pair(cellHash(cell), 0),
+                    [](std::pair<uint64_t, int> const& a, std::pair<uint64_t, int> const& b) {
+                        return a.first < b.first;
+                    });
+                for (auto it = range.first; it != range.second; ++it) {
+                    if ((points.row(point) - referencePoints.row(it->second)).abs().maxCoeff() <= tolerance) {
+                        nearby(point) = true;
+                        break;
+                    }
+                }
+
+                // advance to next cell
+                int dim = 0;
+                while ((dim < cell.rows()) && (cell(dim) == last(dim))) {
+                    cell(dim) = first(dim);
+                    dim++;
+                }
+                if (dim == cell.rows()) {
+                    break;
+                }
+                cell(dim)++;
+            }
+        }
+    });
+
+    return nearby;
+}
+
 // create initial points distribution
 Eigen::ArrayXXd distmesh::utils::createInitialPoints(
     Functional const& distanceFunction, double const initialPointDistance,
     Functional const& elementSizeFunction, Eigen::Ref<Eigen::ArrayXXd const> const boundingBox,
-    Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints) {
+    Eigen::Ref<Eigen::ArrayXXd const> const fixedPoints, unsigned const threads,
+    unsigned const seed) {
     // extract dimension of mesh
     unsigned const dimension = boundingBox.cols();
 
@@ -66,22 +140,29 @@ Eigen::ArrayXXd distmesh::utils::createInitialPoints(
     points = selectMaskedArrayElements<double>(points,
         distanceFunction(points) < constants::geometryEvaluationThreshold * initialPointDistance);
 
-    // clear duplicate points
-    Eigen::Array<bool, Eigen::Dynamic, 1> isUniquePoint =
-        Eigen::Array<bool, Eigen::Dynamic, 1>::Constant(points.rows(), true);
-    for (int i = 0; i < fixedPoints.rows(); ++i)
-    for (int j = 0; j < points.rows(); ++j) {
-        isUniquePoint(j) &= !(fixedPoints.row(i) == points.row(j)).all();
-    }
-    points = selectMaskedArrayElements<double>(points, isUniquePoint);
+    // clear points coinciding with fixed points
+    points = selectMaskedArrayElements<double>(points,
+        !findNearbyPoints(points, fixedPoints, initialPointDistance,
+            constants::geometryEvaluationThreshold * initialPointDistance, threads));
 
     // calculate probability to keep points
     Eigen::ArrayXd probability = 1.0 / elementSizeFunction(points).pow(dimension);
     probability /= probability.maxCoeff();
 
-    // reject points with wrong probability
-    points = selectMaskedArrayElements<double>(points,
-        0.5 * (1.0 + Eigen::ArrayXd::Random(points.rows())) < probability);
+    // reject points with wrong probability, drawing from a random engine of
+    // its own, when seeded, to be independent of other threads
+    Eigen::ArrayXd random(points.rows());
+    if (seed == 0) {
+        random = 0.5 * (1.0 + Eigen::ArrayXd::Random(points.rows()));
+    }
+    else {
+        std::mt19937 engine(seed);
+        std::uniform_real_distribution<double> distribution(0.0, 1.0);
+        for (int point = 0; point < random.rows(); ++point) {
+            random(point) = distribution(engine);
+        }
+    }
+    points = selectMaskedArrayElements<double>(points, random < probability);
 
     // combine fixed and variable points to one array
     Eigen::ArrayXXd finalPoints(points.rows() + fixedPoints.rows(), dimension);
@@ -113,60 +194,411 @@ Eigen::ArrayXXi distmesh::utils::nOverK(unsigned const n, unsigned const k) {
     return combinations;
 }
 
-Eigen::ArrayXXi distmesh::utils::findUniqueEdges(Eigen::Ref<Eigen::ArrayXXi const> const triangulation) {
-    // find all unique combinations
-    auto const combinations = nOverK(triangulation.cols(), 2);
+// sort keys ascending by their lowest bits using a least significant digit radix
+// sort, buffer must have the same size as keys
+static void radixSort(uint64_t* keys, uint64_t* buffer, size_t const count,
+    unsigned const bits) {
+    unsigned const digitBits = 11;
+    std::array<size_t, 1 << digitBits> histogram;
+
+    for (unsigned shift = 0; shift < bits; shift += digitBits) {
+        // count occurrence of each digit and convert to start positions
+        std::fill(histogram.begin(), histogram.end(), 0);
+        for (size_t i = 0; i < count; ++i) {
+            histogram[(keys[i] >> shift) & ((1 << digitBits) - 1)]++;
+        }
+        size_t position = 0;
+        for (auto& bucket : histogram) {
+            std::swap(bucket, position);
+            position += bucket;
+        }
 
-    // find unique edges for all combinations
-    // guarantee direction of edges with lower node index to higher index
-    std::set<std::array<int, 2>> uniqueEdges;
-    std::array<int, 2> edge = {{0, 0}};
-    for (int combination = 0; combination < combinations.rows(); ++combination)
-    for (int triangle = 0; triangle < triangulation.rows(); ++triangle) {
-        edge[0] = triangulation(triangle, combinations(combination, 0));
-        edge[1] = triangulation(triangle, combinations(combination, 1));
+        // stable scatter of keys to buffer
+        for (size_t i = 0; i < count; ++i) {
+            buffer[histogram[(keys[i] >> shift) & ((1 << digitBits) - 1)]++] = keys[i];
+        }
+        std::swap(keys, buffer);
+    }
 
-        edge = edge[1] < edge[0] ? std::array<int, 2>{edge[1], edge[0]} : edge;
+    // result has to be located in original keys array
+    if (((bits + digitBits - 1) / digitBits) % 2 != 0) {
+        std::copy(keys, keys + count, buffer);
+    }
+}
 
-        uniqueEdges.insert(edge);
+// local node indices of all edges of triangles and tetrahedra known at
+// compile time, in the same order as given by nOverK(nodes, 2)
+template <
+    int nodes
+>
+struct ElementEdges;
+
+template <>
+struct ElementEdges<3> {
+    static int const count = 3;
+    static int node(int const edge, int const end) {
+        static int const table[3][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+        return table[edge][end];
+    }
+};
+
+template <>
+struct ElementEdges<4> {
+    static int const count = 6;
+    static int node(int const edge, int const end) {
+        static int const table[6][2] = { { 0, 1 }, { 0, 2 }, { 0, 3 }, { 1, 2 }, { 1, 3 }, { 2, 3 } };
+        return table[edge][end];
     }
+};
 
-    // copy set to eigen array
-    Eigen::ArrayXXi edgeIndices(uniqueEdges.size(), 2);
-    int index = 0;
-    for (auto const& edge : uniqueEdges) {
-        edgeIndices(index, 0) = edge[0];
-        edgeIndices(index, 1) = edge[1];
+// encode all edges as single keys with direction from lower node index to
+// higher index, the loop over the edges of each element is unrolled for
+// triangles and tetrahedra
+static inline uint64_t encodeEdge(uint64_t const a, uint64_t const b, uint64_t const nodeCount) {
+    return a < b ? a * nodeCount + b : b * nodeCount + a;
+}
 
-        index++;
+template <
+    int nodes
+>
+static void encodeElementEdges(Eigen::Ref<Eigen::ArrayXXi const> const triangulation,
+    uint64_t const nodeCount, uint64_t* const keys) {
+    for (int element = 0; element < triangulation.rows(); ++element)
+    for (int edge = 0; edge < ElementEdges<nodes>::count; ++edge) {
+        keys[element * ElementEdges<nodes>::count + edge] = encodeEdge(
+            triangulation(element, ElementEdges<nodes>::node(edge, 0)),
+            triangulation(element, ElementEdges<nodes>::node(edge, 1)), nodeCount);
     }
+}
 
-    return edgeIndices;
+Eigen::ArrayXXi distmesh::utils::findUniqueEdges(Eigen::Ref<Eigen::ArrayXXi const> const triangulation,
+    unsigned const threads) {
+    std::vector<int> edges;
+    std::vector<uint64_t> keys;
+    int const edgeCount = findUniqueEdges(triangulation, edges, keys, threads);
+
+    return Eigen::Map<Eigen::ArrayXXi>(edges.data(), edgeCount, 2);
+}
+
+int distmesh::utils::findUniqueEdges(Eigen::Ref<Eigen::ArrayXXi const> const triangulation,
+    std::vector<int>& edges, std::vector<uint64_t>& keys, unsigned const threads) {
+    if ((triangulation.rows() == 0) || (triangulation.cols() < 2)) {
+        edges.clear();
+        return 0;
+    }
+
+    // encode all edges as single keys, sorting the keys leads to the same
+    // order as comparing node indices lexicographically, the second half
+    // of the keys storage is used as buffer for sorting
+    uint64_t const nodeCount = triangulation.maxCoeff() + 1;
+    size_t const keyCount = triangulation.rows() * triangulation.cols() *
+        (triangulation.cols() - 1) / 2;
+    keys.resize(2 * keyCount);
+    uint64_t* keyData = keys.data();
+    uint64_t* bufferData = keys.data() + keyCount;
+    if (triangulation.cols() == 3) {
+        encodeElementEdges<3>(triangulation, nodeCount, keyData);
+    }
+    else if (triangulation.cols() == 4) {
+        encodeElementEdges<4>(triangulation, nodeCount, keyData);
+    }
+    else {
+        auto const combinations = nOverK(triangulation.cols(), 2);
+
+        for (int element = 0; element < triangulation.rows(); ++element)
+        for (int combination = 0; combination < combinations.rows(); ++combination) {
+            keyData[element * combinations.rows() + combination] = encodeEdge(
+                triangulation(element, combinations(combination, 0)),
+                triangulation(element, combinations(combination, 1)), nodeCount);
+        }
+    }
+
+    // distribute keys into buckets of ranges of their first node, which can be
+    // sorted independently, for a single thread all keys are in one bucket
+    unsigned const bucketCount = threads == 1 ? 1 :
+        8 * (threads == 0 ? parallel::hardwareThreads() : threads);
+    std::vector<size_t> bucketOffsets(bucketCount + 1, 0);
+    if (bucketCount == 1) {
+        bucketOffsets[1] = keyCount;
+    }
+    else {
+        auto const bucket = [=](uint64_t const key) {
+            return (unsigned)(key / nodeCount * bucketCount / nodeCount);
+        };
+        for (size_t i = 0; i < keyCount; ++i) {
+            bucketOffsets[bucket(keyData[i]) + 1]++;
+        }
+        for (unsigned i = 0; i < bucketCount; ++i) {
+            bucketOffsets[i + 1] += bucketOffsets[i];
+        }
+        std::vector<size_t> position(bucketOffsets.begin(), bucketOffsets.end() - 1);
+        for (size_t i = 0; i < keyCount; ++i) {
+            bufferData[position[bucket(keyData[i])]++] = keyData[i];
+        }
+        std::swap(keyData, bufferData);
+    }
+
+    // sort all buckets and remove duplicate edges within each bucket
+    unsigned bits = 0;
+    while ((bits < 64) && ((nodeCount * nodeCount) >> bits) != 0) {
+        bits++;
+    }
+    std::vector<size_t> uniqueCounts(bucketCount, 0);
+    parallel::forEach(bucketCount, threads, [&](unsigned const bucket, unsigned const) {
+        // use pointers, since trailing buckets might be empty
+        uint64_t* const begin = keyData + bucketOffsets[bucket];
+        uint64_t* const end = keyData + bucketOffsets[bucket + 1];
+
+        radixSort(begin, bufferData + bucketOffsets[bucket], end - begin, bits);
+        uniqueCounts[bucket] = std::unique(begin, end) - begin;
+    });
+
+    // copy unique keys of all buckets to the edges
+    std::vector<size_t> edgeOffsets(bucketCount + 1, 0);
+    for (unsigned bucket = 0; bucket < bucketCount; ++bucket) {
+        edgeOffsets[bucket + 1] = edgeOffsets[bucket] + uniqueCounts[bucket];
+    }
+    int const edgeCount = edgeOffsets[bucketCount];
+    edges.resize(2 * edgeCount);
+    Eigen::Map<Eigen::ArrayXXi> edgeIndices(edges.data(), edgeCount, 2);
+    parallel::forEach(bucketCount, threads, [&](unsigned const bucket, unsigned const) {
+        for (size_t i = 0; i < uniqueCounts[bucket]; ++i) {
+            uint64_t const key = keyData[bucketOffsets[bucket] + i];
+            edgeIndices(edgeOffsets[bucket] + i, 0) = key / nodeCount;
+            edgeIndices(edgeOffsets[bucket] + i, 1) = key % nodeCount;
+        }
+    });
+
+    return edgeCount;
+}
+
+// create compressed adjacency of nodes to edges
+std::tuple<Eigen::ArrayXi, Eigen::ArrayXi> distmesh::utils::nodeEdgeAdjacency(
+    Eigen::Ref<Eigen::ArrayXXi const> const edges, unsigned const nodeCount) {
+    std::vector<int> offsets, adjacency;
+    nodeEdgeAdjacency(edges, nodeCount, offsets, adjacency);
+
+    return std::make_tuple(Eigen::Map<Eigen::ArrayXi>(offsets.data(), offsets.size()),
+        Eigen::Map<Eigen::ArrayXi>(adjacency.data(), adjacency.size()));
+}
+
+void distmesh::utils::nodeEdgeAdjacency(Eigen::Ref<Eigen::ArrayXXi const> const edges,
+    unsigned const nodeCount, std::vector<int>& offsets, std::vector<int>& adjacency) {
+    // count edges per node
+    offsets.assign(nodeCount + 1, 0);
+    for (int edge = 0; edge < edges.rows(); ++edge) {
+        offsets[edges(edge, 0) + 1]++;
+        offsets[edges(edge, 1) + 1]++;
+    }
+    for (unsigned node = 0; node < nodeCount; ++node) {
+        offsets[node + 1] += offsets[node];
+    }
+
+    // fill adjacency in order of edges, using the offsets as positions,
+    // which are shifted back by one node afterwards
+    adjacency.resize(2 * edges.rows());
+    for (int edge = 0; edge < edges.rows(); ++edge) {
+        adjacency[offsets[edges(edge, 0)]++] = edge;
+        adjacency[offsets[edges(edge, 1)]++] = -edge - 1;
+    }
+    for (unsigned node = nodeCount; node > 0; --node) {
+        offsets[node] = offsets[node - 1];
+    }
+    offsets[0] = 0;
+}
+
+// move nodes by the sum of forces of all connected edges, accumulating
+// each node in a row of fixed size
+template <
+    int dimension,
+    class type
+>
+static void accumulateNodeForces(
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const forceVector,
+    Eigen::Ref<Eigen::ArrayXi const> const offsets,
+    Eigen::Ref<Eigen::ArrayXi const> const adjacency, type const scale,
+    int const begin, int const end,
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic>> points) {
+    for (int node = begin; node < end; ++node) {
+        Eigen::Array<type, 1, dimension> point = points.row(node);
+        for (int index = offsets(node); index < offsets(node + 1); ++index) {
+            if (adjacency(index) >= 0) {
+                point += scale * forceVector.row(adjacency(index));
+            }
+            else {
+                point -= scale * forceVector.row(-adjacency(index) - 1);
+            }
+        }
+        points.row(node) = point;
+    }
+}
+
+template <
+    class type
+>
+void distmesh::utils::accumulateForces(
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const forceVector,
+    Eigen::Ref<Eigen::ArrayXi const> const offsets,
+    Eigen::Ref<Eigen::ArrayXi const> const adjacency, double const scale,
+    unsigned const firstNode, Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic>> points,
+    unsigned const threads) {
+    // each node only gathers the forces of its own edges, so nodes can be
+    // processed independently, split them into blocks for the thread pool
+    int const nodeCount = offsets.rows() - 1;
+    int const blockCount = threads == 1 ? 1 : 8 * (threads == 0 ? parallel::hardwareThreads() : threads);
+    int const blockSize = (std::max(nodeCount - (int)firstNode, 0) + blockCount - 1) / blockCount;
+
+    parallel::forEach(blockCount, threads, [&](unsigned const block, unsigned const) {
+        int const begin = firstNode + block * blockSize;
+        int const end = std::min(begin + blockSize, nodeCount);
+
+        if (points.cols() == 2) {
+            accumulateNodeForces<2, type>(forceVector, offsets, adjacency, type(scale),
+                begin, end, points);
+        }
+        else if (points.cols() == 3) {
+            accumulateNodeForces<3, type>(forceVector, offsets, adjacency, type(scale),
+                begin, end, points);
+        }
+        else {
+            for (int node = begin; node < end; ++node)
+            for (int index = offsets(node); index < offsets(node + 1); ++index) {
+                if (adjacency(index) >= 0) {
+                    points.row(node) += type(scale) * forceVector.row(adjacency(index));
+                }
+                else {
+                    points.row(node) -= type(scale) * forceVector.row(-adjacency(index) - 1);
+                }
+            }
+        }
+    });
+}
+
+template void distmesh::utils::accumulateForces<float>(
+    Eigen::Ref<Eigen::ArrayXXf const> const, Eigen::Ref<Eigen::ArrayXi const> const,
+    Eigen::Ref<Eigen::ArrayXi const> const, double const, unsigned const,
+    Eigen::Ref<Eigen::ArrayXXf>, unsigned const);
+template void distmesh::utils::accumulateForces<double>(
+    Eigen::Ref<Eigen::ArrayXXd const> const, Eigen::Ref<Eigen::ArrayXi const> const,
+    Eigen::Ref<Eigen::ArrayXi const> const, double const, unsigned const,
+    Eigen::Ref<Eigen::ArrayXXd>, unsigned const);
+
+// vectors, lengths and midpoints of all edges for points of fixed dimension
+template <
+    int dimension,
+    class type
+>
+static void edgeGeometryKernel(
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points,
+    Eigen::Ref<Eigen::ArrayXXi const> const edges,
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic>> vectors,
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, 1>> lengths,
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic>> midpoints) {
+    for (int edge = 0; edge < edges.rows(); ++edge) {
+        Eigen::Array<type, 1, dimension> const a = points.row(edges(edge, 0));
+        Eigen::Array<type, 1, dimension> const b = points.row(edges(edge, 1));
+
+        vectors.row(edge) = a - b;
+        lengths(edge) = std::sqrt((a - b).square().sum());
+        midpoints.row(edge) = type(0.5) * (a + b);
+    }
+}
+
+template <
+    class type
+>
+void distmesh::utils::edgeGeometry(
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points,
+    Eigen::Ref<Eigen::ArrayXXi const> const edges,
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic>> vectors,
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, 1>> lengths,
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic>> midpoints) {
+    if (points.cols() == 2) {
+        edgeGeometryKernel<2, type>(points, edges, vectors, lengths, midpoints);
+    }
+    else if (points.cols() == 3) {
+        edgeGeometryKernel<3, type>(points, edges, vectors, lengths, midpoints);
+    }
+    else {
+        auto const a = selectIndexedArrayElements<type>(points, edges.col(0));
+        auto const b = selectIndexedArrayElements<type>(points, edges.col(1));
+
+        vectors = a - b;
+        lengths = vectors.square().rowwise().sum().sqrt();
+        midpoints = type(0.5) * (a + b);
+    }
+}
+
+template void distmesh::utils::edgeGeometry<float>(
+    Eigen::Ref<Eigen::ArrayXXf const> const, Eigen::Ref<Eigen::ArrayXXi const> const,
+    Eigen::Ref<Eigen::ArrayXXf>, Eigen::Ref<Eigen::ArrayXf>, Eigen::Ref<Eigen::ArrayXXf>);
+template void distmesh::utils::edgeGeometry<double>(
+    Eigen::Ref<Eigen::ArrayXXd const> const, Eigen::Ref<Eigen::ArrayXXi const> const,
+    Eigen::Ref<Eigen::ArrayXXd>, Eigen::Ref<Eigen::ArrayXd>, Eigen::Ref<Eigen::ArrayXXd>);
+
+// create compressed adjacency of edges to elements
+std::tuple<Eigen::ArrayXi, Eigen::ArrayXi> distmesh::utils::edgeElementAdjacency(
+    Eigen::Ref<Eigen::ArrayXXi const> const edgeIndices, unsigned const edgeCount) {
+    // count elements per edge
+    Eigen::ArrayXi offsets = Eigen::ArrayXi::Zero(edgeCount + 1);
+    for (int element = 0; element < edgeIndices.rows(); ++element)
+    for (int edge = 0; edge < edgeIndices.cols(); ++edge) {
+        if (edgeIndices(element, edge) >= 0) {
+            offsets(edgeIndices(element, edge) + 1)++;
+        }
+    }
+    for (unsigned edge = 0; edge < edgeCount; ++edge) {
+        offsets(edge + 1) += offsets(edge);
+    }
+
+    // fill adjacency in order of elements
+    Eigen::ArrayXi adjacency(offsets(edgeCount));
+    Eigen::ArrayXi position = offsets.head(edgeCount);
+    for (int element = 0; element < edgeIndices.rows(); ++element)
+    for (int edge = 0; edge < edgeIndices.cols(); ++edge) {
+        if (edgeIndices(element, edge) >= 0) {
+            adjacency(position(edgeIndices(element, edge))++) = element;
+        }
+    }
+
+    return std::make_tuple(offsets, adjacency);
 }
 
 Eigen::ArrayXXi distmesh::utils::getTriangulationEdgeIndices(
     Eigen::Ref<Eigen::ArrayXXi const> const triangulation,
     Eigen::Ref<Eigen::ArrayXXi const> const edges) {
-    // find indices for each edge of triangulation in edge index array
+    // use adjacency of nodes to edges as lookup index of edges
+    int const nodeCount = std::max(triangulation.size() > 0 ? triangulation.maxCoeff() : 0,
+        edges.size() > 0 ? edges.maxCoeff() : 0) + 1;
+    Eigen::ArrayXi offsets, adjacency;
+    std::tie(offsets, adjacency) = nodeEdgeAdjacency(edges, nodeCount);
+
+    // find indices for each edge of triangulation in edge index array,
+    // edges with same direction are preferred over reversed ones and
+    // edges not contained in the edge list are marked by -1
     Eigen::ArrayXXi edgeIndices(triangulation.rows(), triangulation.cols());
     for (int element = 0; element < triangulation.rows(); ++element)
     for (int node = 0; node < triangulation.cols(); ++node) {
-        // create edge with direction from node with lower index
-        // to node with higher index
-        auto const edge = (Eigen::ArrayXi(2) << triangulation(element, node), triangulation(element, (node + 1) % triangulation.cols())).finished();
-
-        // check if edge is in edges list, and get index
-        int edgeIndex = 0;
-        if (((edges.rowwise() - edge.transpose()).square().rowwise().sum().minCoeff(&edgeIndex) == 0) ||
-            ((edges.rowwise() - edge.transpose().reverse()).square().rowwise().sum().minCoeff(&edgeIndex) == 0)) {
-            edgeIndices(element, node) = edgeIndex;
+        int const start = triangulation(element, node);
+        int const end = triangulation(element, (node + 1) % triangulation.cols());
+
+        int edgeIndex = -1;
+        for (int index = offsets(start); (index < offsets(start + 1)) && (edgeIndex < 0); ++index) {
+            if ((adjacency(index) >= 0) && (edges(adjacency(index), 1) == end)) {
+                edgeIndex = adjacency(index);
+            }
+        }
+        for (int index = offsets(start); (index < offsets(start + 1)) && (edgeIndex < 0); ++index) {
+            if ((adjacency(index) < 0) && (edges(-adjacency(index) - 1, 0) == end)) {
+                edgeIndex = -adjacency(index) - 1;
+            }
         }
+        edgeIndices(element, node) = edgeIndex;
     }
 
     return edgeIndices;
 }
 
-
 // determine boundary edges of given triangulation
 Eigen::ArrayXi distmesh::utils::boundEdges(
     Eigen::Ref<Eigen::ArrayXXi const> const triangulation,
@@ -190,32 +622,111 @@ Eigen::ArrayXi distmesh::utils::boundEdges(
         edgeIndices = _edgeIndices;
     }
 
-    // find edges, which only appear once in triangulation
-    std::set<int> uniqueEdges;
-    std::vector<int> boundaryEdges;
-    for (int triangle = 0; triangle < triangulation.rows(); ++triangle)
-    for (int edge = 0; edge < triangulation.cols(); ++edge) {
-        auto const edgeIndex = edgeIndices(triangle, edge);
+    // count appearance of each edge in triangulation, skipping edges
+    // missing in the edge list
+    Eigen::ArrayXi edgeCount = Eigen::ArrayXi::Zero(edges.rows());
+    for (int triangle = 0; triangle < edgeIndices.rows(); ++triangle)
+    for (int edge = 0; edge < edgeIndices.cols(); ++edge) {
+        if (edgeIndices(triangle, edge) >= 0) {
+            edgeCount(edgeIndices(triangle, edge))++;
+        }
+    }
+
+    // collect edges, which only appear once in triangulation, in order
+    // of their first appearance
+    Eigen::ArrayXi boundary((edgeCount == 1).count());
+    int boundaryCount = 0;
+    for (int triangle = 0; triangle < edgeIndices.rows(); ++triangle)
+    for (int edge = 0; edge < edgeIndices.cols(); ++edge) {
+        if ((edgeIndices(triangle, edge) >= 0) && (edgeCount(edgeIndices(triangle, edge)) == 1)) {
+            boundary(boundaryCount) = edgeIndices(triangle, edge);
+            boundaryCount++;
+        }
+    }
+
+    return boundary;
+}
 
-        // insert edge in set to get info about multiple appearance
-        if (!std::get<1>(uniqueEdges.insert(edgeIndex))) {
-            // find edge in vector and delete it
-            auto const it = std::find(boundaryEdges.begin(), boundaryEdges.end(), edgeIndex);
-            if (it != boundaryEdges.end()) {
-                boundaryEdges.erase(it);
+// determine boundary faces of given triangulation
+Eigen::ArrayXXi distmesh::utils::boundFaces(
+    Eigen::Ref<Eigen::ArrayXXi const> const triangulation) {
+    if ((triangulation.rows() == 0) || (triangulation.cols() < 2)) {
+        return Eigen::ArrayXXi(0, std::max((int)triangulation.cols() - 1, 0));
+    }
+
+    // all faces of each element
+    auto const combinations = nOverK(triangulation.cols(), triangulation.cols() - 1);
+    int const faceCount = triangulation.rows() * combinations.rows();
+
+    // nodes of all faces sorted ascending to compare them independent
+    // of their orientation
+    Eigen::ArrayXXi faces(faceCount, combinations.cols());
+    Eigen::ArrayXXi sortedFaces(faceCount, combinations.cols());
+    for (int element = 0; element < triangulation.rows(); ++element)
+    for (int combination = 0; combination < combinations.rows(); ++combination) {
+        int const face = element * combinations.rows() + combination;
+        for (int node = 0; node < combinations.cols(); ++node) {
+            faces(face, node) = triangulation(element, combinations(combination, node));
+        }
+
+        Eigen::ArrayXi sortedFace = faces.row(face).transpose();
+        std::sort(sortedFace.data(), sortedFace.data() + sortedFace.size());
+        sortedFaces.row(face) = sortedFace.transpose();
+    }
+
+    // group faces by their lowest node, so only faces within a group
+    // can be identical
+    int const nodeCount = triangulation.maxCoeff() + 1;
+    Eigen::ArrayXi offsets = Eigen::ArrayXi::Zero(nodeCount + 1);
+    for (int face = 0; face < faceCount; ++face) {
+        offsets(sortedFaces(face, 0) + 1)++;
+    }
+    for (int node = 0; node < nodeCount; ++node) {
+        offsets(node + 1) += offsets(node);
+    }
+    std::vector<int> groups(faceCount);
+    Eigen::ArrayXi position = offsets.head(nodeCount);
+    for (int face = 0; face < faceCount; ++face) {
+        groups[position(sortedFaces(face, 0))++] = face;
+    }
+
+    // count appearance of each face by sorting each group
+    auto const lessFace = [&](int const a, int const b) {
+        for (int node = 1; node < sortedFaces.cols(); ++node) {
+            if (sortedFaces(a, node) != sortedFaces(b, node)) {
+                return sortedFaces(a, node) < sortedFaces(b, node);
             }
         }
-        else {
-            boundaryEdges.push_back(edgeIndex);
+        return false;
+    };
+    Eigen::ArrayXi faceAppearance = Eigen::ArrayXi::Zero(faceCount);
+    for (int node = 0; node < nodeCount; ++node) {
+        auto const begin = groups.begin() + offsets(node);
+        auto const end = groups.begin() + offsets(node + 1);
+        std::sort(begin, end, lessFace);
+
+        for (auto first = begin; first != end; ) {
+            auto last = first + 1;
+            while ((last != end) && !lessFace(*first, *last)) {
+                last++;
+            }
+            for (auto face = first; face != last; ++face) {
+                faceAppearance(*face) = last - first;
+            }
+            first = last;
         }
     }
 
-    // convert stl vector to eigen array
-    Eigen::ArrayXi boundary(boundaryEdges.size());
-    for (int edge = 0; edge < boundary.rows(); ++edge) {
-        boundary(edge) = boundaryEdges[edge];
+    // collect faces, which only appear once, in order of the elements
+    Eigen::ArrayXXi boundary((faceAppearance == 1).count(), combinations.cols());
+    int boundaryCount = 0;
+    for (int face = 0; face < faceCount; ++face) {
+        if (faceAppearance(face) == 1) {
+            boundary.row(boundaryCount) = faces.row(face);
+            boundaryCount++;
+        }
     }
-    
+
     return boundary;
 }
 
@@ -229,28 +740,31 @@ Eigen::ArrayXXi distmesh::utils::fixBoundaryEdgeOrientation(
 
     // for the 2-D case fix orientation of boundary edges
     if (nodes.cols() == 2) {
-        auto const boundary = utils::boundEdges(triangulation, edges, edgeIndices);
+        // boundary edges are the ones with a single adjacent element
+        Eigen::ArrayXi offsets, elements;
+        std::tie(offsets, elements) = utils::edgeElementAdjacency(edgeIndices, edges.rows());
 
-        for (int edge = 0; edge < boundary.rows(); ++edge) {
-            // find get index of element containing boundary edge
-            int elementIndex = 0, edgeIndex = 0;
-            (edgeIndices - boundary(edge)).square().minCoeff(&elementIndex, &edgeIndex);
+        for (int edge = 0; edge < edges.rows(); ++edge) {
+            if (offsets(edge + 1) - offsets(edge) != 1) {
+                continue;
+            }
+            int const elementIndex = elements(offsets(edge));
 
             // get index of node not used in edge, but in the triangle
             int nodeIndex = 0;
             for (int node = 0; node < triangulation.cols(); ++node) {
-                if ((triangulation(elementIndex, node) != edges(boundary(edge), 0)) &&
-                    (triangulation(elementIndex, node) != edges(boundary(edge), 1))) {
+                if ((triangulation(elementIndex, node) != edges(edge, 0)) &&
+                    (triangulation(elementIndex, node) != edges(edge, 1))) {
                     nodeIndex = node;
                     break;
                 }
             }
 
             // boundary edges with wrong orientation are marked with a negative sign
-            auto const v1 = (nodes.row(edges(boundary(edge), 1)) - nodes.row(edges(boundary(edge), 0))).eval();
-            auto const v2 = (nodes.row(triangulation(elementIndex, nodeIndex)) - nodes.row(edges(boundary(edge), 1))).eval();
+            auto const v1 = (nodes.row(edges(edge, 1)) - nodes.row(edges(edge, 0))).eval();
+            auto const v2 = (nodes.row(triangulation(elementIndex, nodeIndex)) - nodes.row(edges(edge, 1))).eval();
             if (v1(0) * v2(1) - v1(1) * v2(0) < 0.0) {
-                edges.row(boundary(edge)) = edges.row(boundary(edge)).reverse().eval();
+                edges.row(edge) = edges.row(edge).reverse().eval();
             }
         }
     }
@@ -259,42 +773,96 @@ Eigen::ArrayXXi distmesh::utils::fixBoundaryEdgeOrientation(
 }
 
 // project points outside of domain back to boundary
+template <
+    class type
+>
 void distmesh::utils::projectPointsToBoundary(
     Functional const& distanceFunction, double const initialPointDistance,
-    Eigen::Ref<Eigen::ArrayXXd> points) {
-    Eigen::ArrayXd distance = distanceFunction(points);
-
-    // check for points outside of boundary
-    Eigen::Array<bool, Eigen::Dynamic, 1> outside = distance > 0.0;
-    if (outside.any()) {
-        // calculate gradient
-        Eigen::ArrayXXd gradient(points.rows(), points.cols());
-        Eigen::ArrayXXd deltaX = Eigen::ArrayXXd::Zero(points.rows(), points.cols());
-
-        for (int dim = 0; dim < points.cols(); ++dim) {
-            deltaX.col(dim).fill(constants::deltaX * initialPointDistance);
-            gradient.col(dim) = (distanceFunction(points + deltaX) - distance) /
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic>> points) {
+    // single precision points are only cast to double for the points outside
+    // of the boundary, if the distance function provides single precision evaluation
+    Eigen::Array<type, Eigen::Dynamic, 1> const distance = distanceFunction(
+        Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const>(points));
+
+    // gather points outside of boundary in dense batch, since typically
+    // only a thin layer of points near the boundary is affected
+    std::vector<int> outside;
+    for (int point = 0; point < points.rows(); ++point) {
+        if (distance(point) > 0.0) {
+            outside.push_back(point);
+        }
+    }
+    if (outside.empty()) {
+        return;
+    }
+
+    Eigen::ArrayXXd batch(outside.size(), points.cols());
+    Eigen::ArrayXd batchDistance(outside.size());
+    for (size_t point = 0; point < outside.size(); ++point) {
+        batch.row(point) = points.row(outside[point]).template cast<double>();
+        batchDistance(point) = distance(outside[point]);
+    }
+
+    // the finite differences require the distance in double precision
+    if (!std::is_same<type, double>::value) {
+        batchDistance = distanceFunction(batch);
+    }
+
+    // use analytic gradient, if available, or approximate gradient
+    // by finite differences otherwise
+    Eigen::ArrayXXd gradient(batch.rows(), batch.cols());
+    if (distanceFunction.hasGradient()) {
+        gradient = std::get<1>(distanceFunction.gradient()(batch));
+    }
+    else {
+        for (int dim = 0; dim < batch.cols(); ++dim) {
+            batch.col(dim) += constants::deltaX * initialPointDistance;
+            gradient.col(dim) = (distanceFunction(batch) - batchDistance) /
                 (constants::deltaX * initialPointDistance);
-            deltaX.col(dim).fill(0.0);
+            batch.col(dim) -= constants::deltaX * initialPointDistance;
         }
+    }
 
-        // project points back to boundary
-        points -= outside.replicate(1, points.cols()).select(
-            gradient.colwise() * distance / gradient.square().rowwise().sum(), 0.0);
+    // project points back to boundary
+    batch = gradient.colwise() * (batchDistance / gradient.square().rowwise().sum());
+    for (size_t point = 0; point < outside.size(); ++point) {
+        points.row(outside[point]) -= batch.row(point).template cast<type>();
     }
 }
 
+template void distmesh::utils::projectPointsToBoundary<float>(Functional const&,
+    double const, Eigen::Ref<Eigen::ArrayXXf>);
+template void distmesh::utils::projectPointsToBoundary<double>(Functional const&,
+    double const, Eigen::Ref<Eigen::ArrayXXd>);
+
 // check whether points lies inside or outside of polygon
-Eigen::ArrayXd distmesh::utils::pointsInsidePoly(
-    Eigen::Ref<Eigen::ArrayXXd const> const points,
+template <
+    class type
+>
+Eigen::Array<type, Eigen::Dynamic, 1> distmesh::utils::pointsInsidePoly(
+    Eigen::Ref<Eigen::Array<type, Eigen::Dynamic, Eigen::Dynamic> const> const points,
     Eigen::Ref<Eigen::ArrayXXd const> const polygon) {
-    Eigen::ArrayXd inside = Eigen::ArrayXd::Zero(points.rows());
+    Eigen::Array<type, Eigen::Dynamic, 1> inside =
+        Eigen::Array<type, Eigen::Dynamic, 1>::Zero(points.rows());
 
     for (int i = 0, j = polygon.rows() - 1; i < polygon.rows(); j = i++) {
-        inside = (((points.col(1) < polygon(i, 1)) != (points.col(1) < polygon(j, 1))) &&
-            (points.col(0) < (polygon(j, 0) - polygon(i, 0)) * (points.col(1) - polygon(i, 1)) /
-            (polygon(j, 1) - polygon(i, 1)) + polygon(i, 0))).select(1.0 - inside, inside);
+        inside = (((points.col(1) < type(polygon(i, 1))) !=
+            (points.col(1) < type(polygon(j, 1)))) &&
+            (points.col(0) < type(polygon(j, 0) - polygon(i, 0)) *
+            (points.col(1) - type(polygon(i, 1))) / type(polygon(j, 1) - polygon(i, 1)) +
+            type(polygon(i, 0)))).select(type(1) - inside, inside);
     }
 
     return inside;
 }
+
+template Eigen::ArrayXf distmesh::utils::pointsInsidePoly<float>(
+    Eigen::Ref<Eigen::ArrayXXf const> const, Eigen::Ref<Eigen::ArrayXXd const> const);
+template Eigen::ArrayXd distmesh::utils::pointsInsidePoly<double>(
+    Eigen::Ref<Eigen::ArrayXXd const> const, Eigen::Ref<Eigen::ArrayXXd const> const);
+
+Eigen::ArrayXd distmesh::utils::pointsInsidePoly(
+    Eigen::Ref<Eigen::ArrayXXd const> const points,
+    Eigen::Ref<Eigen::ArrayXXd const> const polygon) {
+    return pointsInsidePoly<double>(points, polygon);
+}
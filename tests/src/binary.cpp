@@ -0,0 +1,132 @@
+// --------------------------------------------------------------------
+// This file is part of libDistMesh.
+//
+// libDistMesh is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// libDistMesh is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libDistMesh. If not, see <http://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2015 Patrik Gebhardt
+// Contact: patrik.gebhardt@rub.de
+// --------------------------------------------------------------------
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <distmesh/distmesh.h>
+#include "helper.h"
+
+// report result of a single check
+bool check(std::string const& name, bool const passed) {
+    std::cout << (passed ? "[ PASSED ] " : "[ FAILED ] ") << name << std::endl;
+    return passed;
+}
+
+std::string readFile(std::string const& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+
+    return content.str();
+}
+
+void writeFile(std::string const& filename, std::string const& content) {
+    std::ofstream file(filename, std::ios::binary);
+    file.write(content.data(), content.size());
+}
+
+// mapping the given file has to fail with a runtime error
+bool rejected(std::string const& filename) {
+    try {
+        distmesh::helper::MappedMesh const mesh(filename);
+    }
+    catch (std::runtime_error const&) {
+        return true;
+    }
+
+    return false;
+}
+
+int main() {
+    bool passed = true;
+    std::string const filename = "binary_test_mesh.bin";
+    std::string const corruptedFilename = "binary_test_corrupted.bin";
+
+    // delaunay triangulation of random points with its edges and boundary
+    std::srand(1);
+    Eigen::ArrayXXd const points = Eigen::ArrayXXd::Random(1000, 2);
+    Eigen::ArrayXXi const elements = distmesh::triangulation::delaunay(points);
+    Eigen::ArrayXXi const edges = distmesh::utils::findUniqueEdges(elements);
+    Eigen::ArrayXXi const boundary = distmesh::utils::boundEdges(elements, edges);
+
+    // all arrays are mapped unchanged
+    distmesh::helper::savebin(filename, points, elements, edges, boundary);
+    {
+        distmesh::helper::MappedMesh const mesh(filename);
+        passed &= check("MappedMesh keeps dimension", mesh.dimension() == 2);
+        passed &= check("MappedMesh keeps points", (mesh.points().rows() == points.rows()) &&
+            (mesh.points().cols() == points.cols()) && (mesh.points() == points).all());
+        passed &= check("MappedMesh keeps elements", (mesh.elements().rows() == elements.rows()) &&
+            (mesh.elements().cols() == elements.cols()) && (mesh.elements() == elements).all());
+        passed &= check("MappedMesh keeps edges", (mesh.edges().rows() == edges.rows()) &&
+            (mesh.edges().cols() == edges.cols()) && (mesh.edges() == edges).all());
+        passed &= check("MappedMesh keeps boundary", (mesh.boundary().rows() == boundary.rows()) &&
+            (mesh.boundary().cols() == boundary.cols()) && (mesh.boundary() == boundary).all());
+    }
+
+    // optional sections are empty
+    distmesh::helper::savebin(corruptedFilename, points, elements);
+    {
+        distmesh::helper::MappedMesh const mesh(corruptedFilename);
+        passed &= check("MappedMesh maps mesh without edges and boundary",
+            (mesh.points() == points).all() && (mesh.elements() == elements).all() &&
+            (mesh.edges().size() == 0) && (mesh.boundary().size() == 0));
+    }
+
+    std::string const content = readFile(filename);
+
+    // truncated files, including files shorter than the header
+    for (size_t const length : { content.size() - 1, content.size() / 2,
+        sizeof(distmesh::helper::binary::Header), sizeof(distmesh::helper::binary::Header) / 2,
+        size_t(0) }) {
+        writeFile(corruptedFilename, content.substr(0, length));
+        passed &= check("MappedMesh rejects file truncated to " + std::to_string(length) +
+            " bytes", rejected(corruptedFilename));
+    }
+
+    // file written in the other byte order
+    std::string corrupted = content;
+    uint32_t const swappedByteOrder = 0x04030201;
+    std::memcpy(&corrupted[offsetof(distmesh::helper::binary::Header, byteOrder)],
+        &swappedByteOrder, sizeof(swappedByteOrder));
+    writeFile(corruptedFilename, corrupted);
+    passed &= check("MappedMesh rejects wrong byte order marker", rejected(corruptedFilename));
+
+    // number of rows whose size in bytes overflows
+    distmesh::helper::binary::Header header;
+    std::memcpy(&header, content.data(), sizeof(header));
+    header.rows[distmesh::helper::binary::Points] = uint64_t(1) << 61;
+    corrupted = content;
+    std::memcpy(&corrupted[0], &header, sizeof(header));
+    writeFile(corruptedFilename, corrupted);
+    passed &= check("MappedMesh rejects overflowing section size", rejected(corruptedFilename));
+
+    std::remove(filename.c_str());
+    std::remove(corruptedFilename.c_str());
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+// --------------------------------------------------------------------
+// This file is part of libDistMesh.
+//
+// libDistMesh is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// libDistMesh is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libDistMesh. If not, see <http://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2015 Patrik Gebhardt
+// Contact: patrik.gebhardt@rub.de
+// --------------------------------------------------------------------
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <cstdlib>
+#include <distmesh/distmesh.h>
+
+// unique edges of all elements sorted by std::sort as reference
+std::vector<std::pair<int, int>> sortedEdges(Eigen::Ref<Eigen::ArrayXXi const> const triangulation) {
+    std::vector<std::pair<int, int>> edges;
+    for (int element = 0; element < triangulation.rows(); ++element)
+    for (int i = 0; i < triangulation.cols(); ++i)
+    for (int j = i + 1; j < triangulation.cols(); ++j) {
+        edges.push_back(std::make_pair(
+            std::min(triangulation(element, i), triangulation(element, j)),
+            std::max(triangulation(element, i), triangulation(element, j))));
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    return edges;
+}
+
+std::vector<std::pair<int, int>> toPairs(Eigen::Ref<Eigen::ArrayXXi const> const edges) {
+    std::vector<std::pair<int, int>> pairs;
+    for (int edge = 0; edge < edges.rows(); ++edge) {
+        pairs.push_back(std::make_pair(edges(edge, 0), edges(edge, 1)));
+    }
+
+    return pairs;
+}
+
+// elements with distinct random nodes out of the given number of nodes
+Eigen::ArrayXXi randomElements(int const count, int const nodes, int const nodeCount) {
+    Eigen::ArrayXXi elements(count, nodes);
+    for (int element = 0; element < count; ++element)
+    for (int node = 0; node < nodes; ++node) {
+        do {
+            elements(element, node) = std::rand() % nodeCount;
+        } while ((elements.row(element).head(node) == elements(element, node)).any());
+    }
+
+    return elements;
+}
+
+// report result of a single check
+bool check(std::string const& name, bool const passed) {
+    std::cout << (passed ? "[ PASSED ] " : "[ FAILED ] ") << name << std::endl;
+    return passed;
+}
+
+int main() {
+    bool passed = true;
+    std::srand(1);
+
+    // delaunay triangulation of random points and random elements of different
+    // sizes, the node counts lead to odd and even numbers of radix sort passes
+    std::vector<std::pair<std::string, Eigen::ArrayXXi>> triangulations = {
+        { "delaunay", distmesh::triangulation::delaunay(Eigen::ArrayXXd::Random(10000, 2)) },
+        { "triangles", randomElements(20000, 3, 40) },
+        { "triangles with large node indices", randomElements(20000, 3, 3000000) },
+        { "tetrahedra", randomElements(20000, 4, 5000) },
+        { "simplices of five nodes", randomElements(1000, 5, 500) }
+    };
+
+    // nodes clustered at low indices with a single element at a large index,
+    // which leaves most buckets of the multi threaded sort empty
+    Eigen::ArrayXXi clustered = randomElements(1000, 3, 50);
+    clustered.row(0) << 0, 1, 100000;
+    triangulations.push_back({ "clustered nodes", clustered });
+
+    // fewer edges than buckets
+    triangulations.push_back({ "single triangle", (Eigen::ArrayXXi(1, 3) << 2, 0, 1).finished() });
+
+    for (auto const& triangulation : triangulations) {
+        auto const reference = sortedEdges(triangulation.second);
+
+        // edges and keys are reused for all thread counts, their capacity only grows
+        std::vector<int> edges;
+        std::vector<uint64_t> keys;
+        for (unsigned const threads : { 1u, 2u, 3u, 0u }) {
+            std::string const name = triangulation.first + " with " + std::to_string(threads) +
+                " threads";
+
+            passed &= check("findUniqueEdges matches std::sort for " + name,
+                toPairs(distmesh::utils::findUniqueEdges(triangulation.second, threads)) ==
+                reference);
+
+            int const edgeCount = distmesh::utils::findUniqueEdges(triangulation.second,
+                edges, keys, threads);
+            passed &= check("findUniqueEdges into workspace matches std::sort for " + name,
+                toPairs(Eigen::Map<Eigen::ArrayXXi>(edges.data(), edgeCount, 2)) == reference);
+        }
+    }
+
+    // empty triangulation
+    for (unsigned const threads : { 1u, 4u }) {
+        passed &= check("findUniqueEdges of empty triangulation with " +
+            std::to_string(threads) + " threads",
+            distmesh::utils::findUniqueEdges(Eigen::ArrayXXi(0, 3), threads).rows() == 0);
+    }
+
+    return passed ? 0 : 1;
+}
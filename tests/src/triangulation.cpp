@@ -0,0 +1,88 @@
+// --------------------------------------------------------------------
+// This file is part of libDistMesh.
+//
+// libDistMesh is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// libDistMesh is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libDistMesh. If not, see <http://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2015 Patrik Gebhardt
+// Contact: patrik.gebhardt@rub.de
+// --------------------------------------------------------------------
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdlib>
+#include <distmesh/distmesh.h>
+
+// all triangles with sorted nodes in sorted order to compare triangulations
+std::vector<std::array<int, 3>> normalize(Eigen::Ref<Eigen::ArrayXXi const> const triangulation) {
+    std::vector<std::array<int, 3>> triangles;
+    for (int triangle = 0; triangle < triangulation.rows(); ++triangle) {
+        std::array<int, 3> nodes = {{ triangulation(triangle, 0), triangulation(triangle, 1),
+            triangulation(triangle, 2) }};
+        std::sort(nodes.begin(), nodes.end());
+        triangles.push_back(nodes);
+    }
+    std::sort(triangles.begin(), triangles.end());
+
+    return triangles;
+}
+
+// report result of a single check
+bool check(std::string const& name, bool const passed) {
+    std::cout << (passed ? "[ PASSED ] " : "[ FAILED ] ") << name << std::endl;
+    return passed;
+}
+
+int main() {
+    bool passed = true;
+
+    // random points inside of a square, whose corners form the convex hull
+    std::srand(1);
+    Eigen::ArrayXXd points(1000, 2);
+    points.topRows(4) << -1.0, -1.0, 1.0, -1.0, 1.0, 1.0, -1.0, 1.0;
+    points.bottomRows(points.rows() - 4) = 0.9 * Eigen::ArrayXXd::Random(points.rows() - 4, 2);
+
+    // update after small movements of the interior points has to match the
+    // delaunay triangulation of the moved points
+    for (unsigned step = 0; step < 10; ++step) {
+        Eigen::ArrayXXi triangulation = distmesh::triangulation::delaunay(points);
+        Eigen::ArrayXXd movedPoints = points;
+        movedPoints.bottomRows(points.rows() - 4) += 3e-4 *
+            Eigen::ArrayXXd::Random(points.rows() - 4, 2);
+
+        bool const updated = distmesh::triangulation::updateDelaunay(movedPoints,
+            points, triangulation);
+        passed &= check("updateDelaunay matches delaunay after step " + std::to_string(step),
+            !updated || (normalize(triangulation) ==
+                normalize(distmesh::triangulation::delaunay(movedPoints))));
+        passed &= check("updateDelaunay succeeds after step " + std::to_string(step), updated);
+
+        points = movedPoints;
+    }
+
+    // a hull point moving inwards changes the convex hull without inverting
+    // any element, which cannot be repaired by edge flips
+    Eigen::ArrayXXd hullPoints(6, 2);
+    hullPoints << -1.0, -1.0, 1.0, -1.0, 1.0, 1.0, -1.0, 1.0, 0.0, -1.05, 0.0, 0.0;
+    Eigen::ArrayXXi triangulation = distmesh::triangulation::delaunay(hullPoints);
+    Eigen::ArrayXXd movedHullPoints = hullPoints;
+    movedHullPoints(4, 1) = -0.95;
+
+    bool const updated = distmesh::triangulation::updateDelaunay(movedHullPoints,
+        hullPoints, triangulation);
+    passed &= check("updateDelaunay rejects changed convex hull", !updated);
+
+    return passed ? 0 : 1;
+}